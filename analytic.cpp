@@ -0,0 +1,202 @@
+#include "analytic.h"
+
+#include <algorithm>
+#include "profile.h"
+#include "schedulers.h"
+using namespace std;
+
+bool qualifiesForAnalytic(const ProcessTable& table) {
+    if (table.stream) {
+        return false;
+    }
+    const Workload& workload = table.workload;
+    for (size_t i = 0; i < workload.numProcesses; i++) {
+        if (workload.numCpuBursts[i] != 1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Run the n processes back to back in the order given by orderAt(k), as the
+// event loop would: each starts once the CPU is free and it has arrived,
+// idling the CPU up to its arrival otherwise (Lindley's recursion,
+// end = max(end, arrival) + burst). Metrics are added in completion order,
+// as the event loop adds them, so even their floating-point sums agree.
+template <typename Order>
+static void runInOrder(ProcessTable& table, size_t n, Order orderAt, TraceSink& trace) {
+    PROFILE_SCOPE(PHASE_ACCOUNT);
+    const Workload& workload = table.workload;
+    RunMetrics& metrics = table.metrics;
+    SimTime end = 0; // When the CPU is next free
+    for (size_t k = 0; k < n; k++) {
+        int id = orderAt(k);
+        SimTime arrival = workload.arrivalTime[id];
+        SimTime burst = workload.totalCpuBurstTime[id];
+        SimTime start = end;
+        if (arrival > end) {
+            start = arrival;
+            trace.idle(start);
+        }
+        end = start + burst;
+
+        table.noteDispatch(id, start);
+        trace.dispatch(start, id, 0, burst, false);
+
+        table.state[id] = COMPLETED;
+        table.currentCpuBurst[id] = 1;
+        table.remainingCpuBurst[id] = 0;
+        table.completionTime[id] = end;
+        metrics.burstWaiting.add(start - arrival);
+        metrics.turnaround.add(end - arrival);
+        metrics.waiting.add(start - arrival);
+        metrics.cpuTime += burst;
+        metrics.makespan = max<SimTime>(metrics.makespan, end);
+    }
+    table.events += n;
+}
+
+bool analyticFifo(ProcessTable& table, TraceSink& trace) {
+    const Workload& workload = table.workload;
+    size_t n = workload.numProcesses;
+    if (!qualifiesForAnalytic(table) || !is_sorted(workload.arrivalTime, workload.arrivalTime + n)) {
+        return false;
+    }
+    runInOrder(table, n, [](size_t k) { return (int)k; }, trace);
+    return true;
+}
+
+// LSD radix sort of 64-bit keys, 11 bits per pass. Passes over digits on
+// which every key agrees are skipped, so keys with few significant bits
+// (short bursts, a small process count) take only a few linear passes.
+static void radixSort(RunVector<uint64_t>& keys, RunVector<uint64_t>& scratch) {
+    const int DIGIT_BITS = 11;
+    const size_t BUCKETS = (size_t)1 << DIGIT_BITS;
+    uint64_t anySet = 0, allSet = ~(uint64_t)0;
+    for (uint64_t key : keys) {
+        anySet |= key;
+        allSet &= key;
+    }
+    uint64_t differing = anySet ^ allSet;
+
+    scratch.resize(keys.size());
+    size_t counts[BUCKETS];
+    for (int shift = 0; shift < 64; shift += DIGIT_BITS) {
+        if (((differing >> shift) & (BUCKETS - 1)) == 0) {
+            continue;
+        }
+        fill(counts, counts + BUCKETS, 0);
+        for (uint64_t key : keys) {
+            counts[(key >> shift) & (BUCKETS - 1)]++;
+        }
+        size_t position = 0;
+        for (size_t& count : counts) {
+            size_t bucketSize = count;
+            count = position;
+            position += bucketSize;
+        }
+        for (uint64_t key : keys) {
+            scratch[counts[(key >> shift) & (BUCKETS - 1)]++] = key;
+        }
+        keys.swap(scratch);
+    }
+}
+
+bool analyticSjf(ProcessTable& table, TraceSink& trace) {
+    const Workload& workload = table.workload;
+    const int32_t* arrival = workload.arrivalTime;
+    const int32_t* burst = workload.totalCpuBurstTime;
+    size_t n = workload.numProcesses;
+    if (!qualifiesForAnalytic(table)) {
+        return false;
+    }
+    if (n == 0) {
+        return true;
+    }
+
+    // The first dispatch is the shortest of the earliest arrivals, lowest
+    // ID on ties
+    int32_t firstArrival = *min_element(arrival, arrival + n);
+    int32_t lastArrival = *max_element(arrival, arrival + n);
+    int leader = -1;
+    for (size_t i = 0; i < n; i++) {
+        if (arrival[i] == firstArrival && (leader == -1 || burst[i] < burst[leader])) {
+            leader = (int)i;
+        }
+    }
+    if (lastArrival > (SimTime)firstArrival + burst[leader]) {
+        return false;
+    }
+
+    // Everyone else is waiting when the leader finishes. Equal bursts go in
+    // ready-queue order: those released with the leader first, then by ID,
+    // as each release is. Keys pack (burst, released later, ID).
+    RunVector<uint64_t> keys;
+    RunVector<uint64_t> scratch;
+    {
+        PROFILE_SCOPE(PHASE_SELECT);
+        keys.reserve(n - 1);
+        for (size_t i = 0; i < n; i++) {
+            if ((int)i != leader) {
+                uint64_t releasedLater = arrival[i] != firstArrival;
+                keys.push_back((uint64_t)burst[i] << 32 | releasedLater << 31 | i);
+            }
+        }
+        radixSort(keys, scratch);
+    }
+    const uint64_t ID_MASK = ((uint64_t)1 << 31) - 1;
+    runInOrder(table, n, [&](size_t k) { return k == 0 ? leader : (int)(keys[k - 1] & ID_MASK); }, trace);
+    return true;
+}
+
+static bool sameHistogram(const StreamingHistogram& a, const StreamingHistogram& b) {
+    return a.count() == b.count() && a.mean() == b.mean() && a.max() == b.max() && a.percentile(50) == b.percentile(50) &&
+           a.percentile(95) == b.percentile(95) && a.percentile(99) == b.percentile(99);
+}
+
+AnalyticCheck checkAnalytic(const string& algorithm, const Workload& workload, string& difference) {
+    if (algorithm != "FIFO" && algorithm != "SJF") {
+        return ANALYTIC_NOT_APPLICABLE;
+    }
+    ProcessTable analytic(workload);
+    ProcessTable eventDriven(workload);
+    TraceSink silent(TRACE_OFF);
+    if (algorithm == "FIFO" && analyticFifo(analytic, silent)) {
+        fifoScheduling(eventDriven, silent);
+    } else if (algorithm == "SJF" && analyticSjf(analytic, silent)) {
+        sjfScheduling(eventDriven, silent);
+    } else {
+        return ANALYTIC_NOT_APPLICABLE;
+    }
+
+    for (int i = 0; i < analytic.size(); i++) {
+        if (analytic.completionTime[i] != eventDriven.completionTime[i] ||
+            analytic.firstRunTime[i] != eventDriven.firstRunTime[i]) {
+            difference = "P" + to_string(i + 1) + " runs from " + to_string(analytic.firstRunTime[i]) + " to " +
+                         to_string(analytic.completionTime[i]) + " analytically but from " +
+                         to_string(eventDriven.firstRunTime[i]) + " to " + to_string(eventDriven.completionTime[i]) +
+                         " in the event loop";
+            return ANALYTIC_DIFFERS;
+        }
+    }
+    const RunMetrics& a = analytic.metrics;
+    const RunMetrics& b = eventDriven.metrics;
+    const pair<const char*, bool> checks[] = {
+        {"dispatch count", analytic.dispatches == eventDriven.dispatches},
+        {"event count", analytic.events == eventDriven.events},
+        {"context switches", a.contextSwitches == b.contextSwitches},
+        {"CPU time", a.cpuTime == b.cpuTime},
+        {"makespan", a.makespan == b.makespan},
+        {"turnaround times", sameHistogram(a.turnaround, b.turnaround)},
+        {"waiting times", sameHistogram(a.waiting, b.waiting)},
+        {"response times", sameHistogram(a.response, b.response)},
+        {"burst waiting times", sameHistogram(a.burstWaiting, b.burstWaiting)},
+    };
+    for (const auto& [name, same] : checks) {
+        if (!same) {
+            difference = string(name) + " differ";
+            return ANALYTIC_DIFFERS;
+        }
+    }
+    return ANALYTIC_MATCHES;
+}
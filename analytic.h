@@ -0,0 +1,40 @@
+#ifndef ANALYTIC_H
+#define ANALYTIC_H
+
+#include <string>
+#include "simulator.h"
+#include "trace.h"
+
+// Closed-form FIFO and SJF for workloads without I/O, where every process
+// is a single CPU burst. Non-preemptive runs of such workloads are fixed by
+// their dispatch order alone: each process starts when the CPU frees up or
+// when it arrives, whichever is later, so completion, turnaround and waiting
+// times follow from one pass over the bursts in that order instead of the
+// event loop. The table, the metrics and the trace come out exactly as
+// fifoScheduling and sjfScheduling would leave them.
+
+// Batch (not streaming) runs in which every process has one CPU burst
+bool qualifiesForAnalytic(const ProcessTable& table);
+
+// FIFO: the workload must also be sorted by arrival time, so the ready
+// queue order is the process order. Returns false, leaving the table
+// untouched, if the workload does not qualify.
+bool analyticFifo(ProcessTable& table, TraceSink& trace);
+
+// SJF: every process must have arrived by the time the first one dispatched
+// finishes, so after it the rest run shortest first as one batch. Returns
+// false, leaving the table untouched, if the workload does not qualify.
+bool analyticSjf(ProcessTable& table, TraceSink& trace);
+
+enum AnalyticCheck {
+    ANALYTIC_NOT_APPLICABLE, // Not FIFO or SJF, or the workload does not qualify
+    ANALYTIC_MATCHES,
+    ANALYTIC_DIFFERS,
+};
+
+// Run `algorithm` on `workload` both analytically and through the event
+// loop, on fresh tables, and compare every per-process result and metric;
+// `difference` describes the first mismatch
+AnalyticCheck checkAnalytic(const std::string& algorithm, const Workload& workload, std::string& difference);
+
+#endif
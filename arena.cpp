@@ -0,0 +1,40 @@
+#include "arena.h"
+
+#include <algorithm>
+using namespace std;
+
+thread_local RunArena* RunArena::active = nullptr;
+
+RunArena::Scope::Scope(RunArena& arena) : previous(active) {
+    arena.rewind();
+    active = &arena;
+}
+
+RunArena::Scope::~Scope() {
+    active = previous;
+}
+
+void* RunArena::Overflow::do_allocate(size_t bytes, size_t alignment) {
+    requested += bytes;
+    return pmr::new_delete_resource()->allocate(bytes, alignment);
+}
+
+void RunArena::Overflow::do_deallocate(void* p, size_t bytes, size_t alignment) {
+    pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+}
+
+void RunArena::rewind() {
+    // Destroying the bump resource hands back its overflow
+    bump.reset();
+    fill(begin(freeBlocks), end(freeBlocks), nullptr);
+    if (overflow.requested > 0) {
+        bufferSize += overflow.requested;
+        buffer.reset(new byte[bufferSize]);
+        overflow.requested = 0;
+    }
+    if (buffer) {
+        bump.emplace(buffer.get(), bufferSize, &overflow);
+    } else {
+        bump.emplace(&overflow);
+    }
+}
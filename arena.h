@@ -0,0 +1,148 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <set>
+#include <vector>
+
+// Memory for the mutable state of one run at a time: the process table,
+// the event queue and the scheduler's queues. Small blocks freed during a
+// run go on a free list per size and are reused by the same run, which is
+// what node containers like the CFS timeline need; larger ones are only
+// reclaimed when the next run starts and everything is dropped at once.
+// The arena keeps its buffer between runs and grows it by whatever the last
+// run needed beyond it, so once every algorithm has run on a trace, running
+// them again on that trace makes no heap allocations at all.
+class RunArena {
+public:
+    RunArena() { rewind(); }
+    RunArena(const RunArena&) = delete;
+    RunArena& operator=(const RunArena&) = delete;
+
+    // While a Scope is alive, run-state containers created on its thread
+    // allocate from `arena`. Opening one starts a new run, so nothing the
+    // previous run allocated from the arena may still be alive.
+    class Scope {
+    public:
+        explicit Scope(RunArena& arena);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        RunArena* previous;
+    };
+
+    // The arena of the innermost Scope on this thread, nullptr outside any
+    static RunArena* current() { return active; }
+
+    void* allocate(size_t bytes, size_t alignment) {
+        if (bytes <= MAX_POOLED_BYTES && alignment <= POOL_ALIGNMENT) {
+            size_t sizeClass = sizeClassOf(bytes);
+            if (FreeBlock* block = freeBlocks[sizeClass]) {
+                freeBlocks[sizeClass] = block->next;
+                return block;
+            }
+            return bump->allocate(sizeClass * POOL_ALIGNMENT, POOL_ALIGNMENT);
+        }
+        return bump->allocate(bytes, alignment);
+    }
+
+    void deallocate(void* p, size_t bytes, size_t alignment) {
+        if (bytes <= MAX_POOLED_BYTES && alignment <= POOL_ALIGNMENT) {
+            size_t sizeClass = sizeClassOf(bytes);
+            FreeBlock* block = static_cast<FreeBlock*>(p);
+            block->next = freeBlocks[sizeClass];
+            freeBlocks[sizeClass] = block;
+        }
+    }
+
+    size_t capacity() const { return bufferSize; }
+
+private:
+    static const size_t POOL_ALIGNMENT = 16;
+    static const size_t MAX_POOLED_BYTES = 1024; // Up to a deque block
+
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    // The heap, for whatever does not fit the buffer; counts what it hands
+    // out so the next run's buffer can hold it
+    class Overflow : public std::pmr::memory_resource {
+    public:
+        size_t requested = 0;
+
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+    };
+
+    std::unique_ptr<std::byte[]> buffer;
+    size_t bufferSize = 0;
+    Overflow overflow;
+    std::optional<std::pmr::monotonic_buffer_resource> bump;
+    FreeBlock* freeBlocks[MAX_POOLED_BYTES / POOL_ALIGNMENT + 1] = {};
+
+    static thread_local RunArena* active;
+
+    static size_t sizeClassOf(size_t bytes) { return (std::max<size_t>(bytes, 1) + POOL_ALIGNMENT - 1) / POOL_ALIGNMENT; }
+
+    // Drop every allocation, growing the buffer first if the last run overflowed it
+    void rewind();
+};
+
+// Allocator for run state. It takes the current RunArena when the container
+// is created and allocates from it for the container's lifetime; outside any
+// RunArena::Scope it uses the heap like std::allocator.
+template <typename T>
+class RunAllocator {
+public:
+    using value_type = T;
+
+    RunAllocator() noexcept : arena(RunArena::current()) {}
+    template <typename U>
+    RunAllocator(const RunAllocator<U>& other) noexcept : arena(other.arena) {}
+
+    T* allocate(size_t count) {
+        if (arena) {
+            return static_cast<T*>(arena->allocate(count * sizeof(T), alignof(T)));
+        }
+        return std::allocator<T>().allocate(count);
+    }
+
+    void deallocate(T* p, size_t count) noexcept {
+        if (arena) {
+            arena->deallocate(p, count * sizeof(T), alignof(T));
+        } else {
+            std::allocator<T>().deallocate(p, count);
+        }
+    }
+
+    template <typename U>
+    bool operator==(const RunAllocator<U>& other) const noexcept { return arena == other.arena; }
+    template <typename U>
+    bool operator!=(const RunAllocator<U>& other) const noexcept { return arena != other.arena; }
+
+private:
+    template <typename U>
+    friend class RunAllocator;
+
+    RunArena* arena;
+};
+
+template <typename T>
+using RunVector = std::vector<T, RunAllocator<T>>;
+template <typename T>
+using RunDeque = std::deque<T, RunAllocator<T>>;
+template <typename T, typename Compare = std::less<T>>
+using RunSet = std::set<T, Compare, RunAllocator<T>>;
+
+#endif
@@ -0,0 +1,231 @@
+#include "batch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <dirent.h>
+#include <glob.h>
+#include <sys/stat.h>
+#include "thread_pool.h"
+#include "workload.h"
+using namespace std;
+
+bool listWorkloadFiles(const vector<string>& patterns, vector<string>& files) {
+    bool ok = true;
+    for (const string& pattern : patterns) {
+        vector<string> matched;
+        struct stat info;
+        if (stat(pattern.c_str(), &info) == 0 && S_ISDIR(info.st_mode)) {
+            DIR* dir = opendir(pattern.c_str());
+            if (!dir) {
+                cerr << pattern << ": " << strerror(errno) << endl;
+                ok = false;
+                continue;
+            }
+            string prefix = pattern.back() == '/' ? pattern : pattern + "/";
+            while (dirent* entry = readdir(dir)) {
+                string path = prefix + entry->d_name;
+                if (entry->d_name[0] != '.' && stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode)) {
+                    matched.push_back(path);
+                }
+            }
+            closedir(dir);
+            sort(matched.begin(), matched.end());
+        } else {
+            // glob() sorts its matches; a plain path matches itself
+            glob_t found;
+            if (glob(pattern.c_str(), 0, nullptr, &found) == 0) {
+                matched.assign(found.gl_pathv, found.gl_pathv + found.gl_pathc);
+            }
+            globfree(&found);
+        }
+        if (matched.empty()) {
+            cerr << pattern << ": no workload files" << endl;
+            ok = false;
+        }
+        files.insert(files.end(), matched.begin(), matched.end());
+    }
+    return ok;
+}
+
+// One algorithm and quantum, run on every trace
+struct BatchRun {
+    string algorithm;
+    int timeQuantum;
+};
+
+// A file between being admitted and being reported
+struct TraceJob {
+    string path;
+    unique_ptr<Workload> workload; // Dropped as soon as its last run ends
+    bool failed = false;
+    vector<RunSummary> summaries; // One per BatchRun
+    atomic<size_t> runsLeft{0};
+    bool done = false;            // Guarded by the pipeline lock
+};
+
+// Bookkeeping shared by the three stages
+struct BatchPipeline {
+    mutex lock;
+    condition_variable slotFree; // The writer reported a trace
+    condition_variable jobDone;  // A trace finished loading or running
+    vector<unique_ptr<TraceJob>> jobs;
+    size_t inFlight = 0;
+
+    void finish(TraceJob& job) {
+        lock_guard<mutex> guard(lock);
+        job.done = true;
+        jobDone.notify_all();
+    }
+};
+
+// Running totals of one BatchRun over the traces reported so far
+struct BatchTotals {
+    size_t traces = 0;
+    double turnaround = 0;
+    double waiting = 0;
+    SimTime makespan = 0;
+};
+
+bool runBatch(const vector<string>& files, const BatchOptions& options, ostream& out) {
+    vector<BatchRun> runs;
+    for (const string& algorithm : options.algorithms) {
+        if (usesTimeQuantum(algorithm)) {
+            for (int quantum : options.quanta) {
+                runs.push_back({algorithm, quantum});
+            }
+        } else {
+            runs.push_back({algorithm, 0});
+        }
+    }
+
+    auto start = chrono::steady_clock::now();
+    BatchPipeline pipeline;
+    pipeline.jobs.resize(files.size());
+    vector<BatchTotals> totals(runs.size());
+    size_t failures = 0;
+    ThreadPool pool(options.threads);
+    size_t inFlightLimit = options.inFlight ? options.inFlight : 2 * (size_t)pool.size();
+
+    auto quantumOf = [](const BatchRun& run) { return usesTimeQuantum(run.algorithm) ? to_string(run.timeQuantum) : "-"; };
+
+    // Writer: reports traces in file order, each as soon as it and every
+    // earlier one are done, then frees its slot
+    out << "File\tAlgorithm\tQuantum\tATAT\t\tAWT\t\tMakespan\n";
+    thread writer([&] {
+        for (size_t i = 0; i < files.size(); i++) {
+            unique_ptr<TraceJob> job;
+            {
+                unique_lock<mutex> guard(pipeline.lock);
+                pipeline.jobDone.wait(guard, [&] { return pipeline.jobs[i] && pipeline.jobs[i]->done; });
+                job = move(pipeline.jobs[i]);
+            }
+            ostringstream rows;
+            if (job->failed) {
+                rows << job->path << "\tfailed to load\n";
+                failures++;
+            } else {
+                for (size_t r = 0; r < runs.size(); r++) {
+                    const RunSummary& summary = job->summaries[r];
+                    rows << job->path << "\t" << runs[r].algorithm << "\t" << quantumOf(runs[r]) << "\t" << setw(8)
+                         << summary.averageTurnaroundTime << "\t" << setw(8) << summary.averageWaitingTime << "\t"
+                         << summary.makespan << "\n";
+                    BatchTotals& total = totals[r];
+                    total.traces++;
+                    total.turnaround += summary.averageTurnaroundTime;
+                    total.waiting += summary.averageWaitingTime;
+                    total.makespan = max(total.makespan, summary.makespan);
+                }
+            }
+            out << rows.str();
+            job.reset();
+            lock_guard<mutex> guard(pipeline.lock);
+            pipeline.inFlight--;
+            pipeline.slotFree.notify_one();
+        }
+    });
+
+    // Reader: admits files in order while there is room in flight; the
+    // pool's workers parse each one and then simulate its runs
+    for (size_t i = 0; i < files.size(); i++) {
+        TraceJob* job;
+        {
+            unique_lock<mutex> guard(pipeline.lock);
+            pipeline.slotFree.wait(guard, [&] { return pipeline.inFlight < inFlightLimit; });
+            pipeline.inFlight++;
+            pipeline.jobs[i].reset(new TraceJob());
+            job = pipeline.jobs[i].get();
+        }
+        job->path = files[i];
+        pool.submit([&pipeline, &pool, &runs, &options, job] {
+            job->workload.reset(new Workload());
+            string deviceError;
+            if (!readWorkloadFile(job->path, *job->workload, options.verifyTraces)) {
+                job->failed = true;
+            } else if (!checkDevices(*job->workload, options.scheduler, deviceError)) {
+                cerr << job->path << ": " << deviceError << endl;
+                job->failed = true;
+            }
+            if (job->failed) {
+                job->workload.reset();
+                pipeline.finish(*job);
+                return;
+            }
+            job->summaries.resize(runs.size());
+            job->runsLeft = runs.size();
+            if (runs.empty()) {
+                job->workload.reset();
+                pipeline.finish(*job);
+                return;
+            }
+            for (size_t r = 0; r < runs.size(); r++) {
+                pool.submit([&pipeline, &runs, &options, job, r] {
+                    // Each worker reuses one arena for all of its runs, as in sweep
+                    static thread_local RunArena arena;
+                    {
+                        RunArena::Scope scope(arena);
+                        ProcessTable table(*job->workload);
+                        SchedulerOptions schedulerOptions = options.scheduler;
+                        schedulerOptions.timeQuantum = runs[r].timeQuantum;
+                        TraceSink silent(TRACE_OFF);
+                        runScheduler(runs[r].algorithm, table, schedulerOptions, silent);
+                        job->summaries[r] = summarizeRun(table);
+                    }
+                    if (--job->runsLeft == 0) {
+                        job->workload.reset();
+                        pipeline.finish(*job);
+                    }
+                });
+            }
+        });
+    }
+    writer.join();
+    pool.wait();
+    double elapsedMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    out << "\nAlgorithm\tQuantum\tTraces\tMean ATAT\tMean AWT\tMax makespan\n";
+    for (size_t r = 0; r < runs.size(); r++) {
+        const BatchTotals& total = totals[r];
+        double traces = max<size_t>(total.traces, 1);
+        out << runs[r].algorithm << "\t" << quantumOf(runs[r]) << "\t" << total.traces << "\t" << setw(8)
+            << total.turnaround / traces << "\t" << setw(8) << total.waiting / traces << "\t" << total.makespan << "\n";
+    }
+    out << flush;
+    // Timing varies from run to run, so it stays out of the report
+    cerr << files.size() << " traces";
+    if (failures) {
+        cerr << " (" << failures << " failed to load)";
+    }
+    cerr << ", " << (files.size() - failures) * runs.size() << " runs on " << pool.size() << " threads in " << elapsedMs
+         << " ms" << endl;
+    return failures == 0;
+}
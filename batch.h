@@ -0,0 +1,35 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "schedulers.h"
+
+struct BatchOptions {
+    std::vector<std::string> algorithms = {"FIFO", "SJF", "SRTF", "CFS", "RR", "MLFQ"};
+    std::vector<int> quanta = {4}; // Time quanta to try with RR, LOTTERY and STRIDE
+    SchedulerOptions scheduler;    // Settings shared by every run
+    unsigned threads = 0;          // 0 means one per core
+    size_t inFlight = 0;           // Traces loaded but not yet reported at once; 0 means two per thread
+    bool verifyTraces = false;     // Decode every burst of each binary trace as it loads
+};
+
+// Expand each argument into workload files: a directory gives its
+// non-hidden regular files, anything else is matched as a glob pattern.
+// Each argument's files are sorted by name. Problems go to stderr.
+bool listWorkloadFiles(const std::vector<std::string>& patterns, std::vector<std::string>& files);
+
+// Run every (algorithm, quantum) combination on every file and write one
+// report to out: a row per run in file order, then averages per
+// combination over the files. The files go through a bounded pipeline:
+// this thread admits files in order while fewer than options.inFlight
+// are loaded or awaiting their turn in the report, the pool's workers
+// parse them and simulate their runs, and a writer thread reports each trace
+// once all of its runs are done and every earlier trace has been reported.
+// The run count and wall-clock time go to stderr, so reports on the same
+// files are identical. Returns false if any file could not be loaded.
+bool runBatch(const std::vector<std::string>& files, const BatchOptions& options, std::ostream& out);
+
+#endif
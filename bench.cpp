@@ -0,0 +1,281 @@
+// Throughput benchmark for the schedulers on synthetic workloads
+//
+//   ./bench [--processes N] [--seed S] [--distribution exponential|bimodal|heavy-tailed]
+//           [--mean-burst B] [--io-ratio R] [--bursts K] [--load L] [--cpus C] [--quantum Q]
+//           [--devices LIST] [--repeat R] [--output trace.bin] [--baseline FILE] [--save-baseline FILE]
+//           [--tolerance T]
+//
+// Each scheduler runs with tracing off and the best of --repeat runs is
+// reported, along with the heap allocations of its last run: every run
+// keeps its state in one reused arena, so once each scheduler has run
+// once that should be zero. With --baseline, any scheduler whose ns/dispatch grew by more
+// than the tolerance (default 0.25) is flagged and the exit status is 2.
+// --devices takes main's device list; processes are dealt over the devices
+// in turn.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <new>
+#include <vector>
+#include <sys/resource.h>
+#include "analytic.h"
+#include "arena.h"
+#include "profile.h"
+#include "schedulers.h"
+#include "trace.h"
+#include "workload_generator.h"
+using namespace std;
+
+// Every heap allocation this program makes goes through here and is counted
+atomic<long long> heapAllocations(0);
+
+void* operator new(size_t bytes) {
+    heapAllocations.fetch_add(1, memory_order_relaxed);
+    if (void* p = malloc(bytes ? bytes : 1)) {
+        return p;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+void* operator new(size_t bytes, align_val_t alignment) {
+    heapAllocations.fetch_add(1, memory_order_relaxed);
+    size_t align = (size_t)alignment;
+    if (void* p = aligned_alloc(align, (bytes + align - 1) / align * align)) {
+        return p;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void* p, align_val_t) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t, align_val_t) noexcept {
+    free(p);
+}
+
+struct BenchResult {
+    string algorithm;
+    double seconds = 0;
+    long long dispatches = 0;
+    long long events = 0;
+    long long allocations = 0; // Heap allocations of the last run, table setup included
+};
+
+// Peak resident set size of this process so far, in KiB
+long peakRssKb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// Baseline files hold one line per algorithm: "<config> <algorithm> <ns/dispatch> <events/sec>"
+map<string, double> loadBaseline(const string& path, const string& configKey) {
+    map<string, double> nsPerDispatch;
+    ifstream in(path);
+    string line;
+    while (getline(in, line)) {
+        istringstream fields(line);
+        string key, algorithm;
+        double ns, eventsPerSec;
+        if (fields >> key >> algorithm >> ns >> eventsPerSec && key == configKey) {
+            nsPerDispatch[algorithm] = ns;
+        }
+    }
+    return nsPerDispatch;
+}
+
+int main(int argc, char* argv[]) {
+    GeneratorConfig config;
+    int quantum = 4;
+    int repeat = 3;
+    double tolerance = 0.25;
+    string outputPath, baselinePath, saveBaselinePath, deviceList;
+    SchedulerOptions options;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (i + 1 >= argc) {
+            cerr << "Missing value for " << arg << endl;
+            return 1;
+        }
+        string value = argv[++i];
+        try {
+            if (arg == "--processes") {
+                config.numProcesses = stoi(value);
+            } else if (arg == "--seed") {
+                config.seed = stoull(value);
+            } else if (arg == "--distribution") {
+                if (!parseBurstDistribution(value, config.distribution)) {
+                    cerr << "--distribution must be exponential, bimodal or heavy-tailed" << endl;
+                    return 1;
+                }
+            } else if (arg == "--mean-burst") {
+                config.meanCpuBurst = stod(value);
+            } else if (arg == "--io-ratio") {
+                config.ioRatio = stod(value);
+            } else if (arg == "--bursts") {
+                config.meanCpuBursts = stod(value);
+            } else if (arg == "--load") {
+                config.load = stod(value);
+            } else if (arg == "--cpus") {
+                config.cpus = stoi(value);
+            } else if (arg == "--devices") {
+                if (!parseDeviceList(value, options.devices)) {
+                    cerr << "--devices must be a list of positive slot counts, each optionally followed by :fifo or :sstf"
+                         << endl;
+                    return 1;
+                }
+                deviceList = value;
+                config.devices = (int)options.devices.size();
+            } else if (arg == "--quantum") {
+                quantum = stoi(value);
+            } else if (arg == "--repeat") {
+                repeat = stoi(value);
+            } else if (arg == "--output") {
+                outputPath = value;
+            } else if (arg == "--baseline") {
+                baselinePath = value;
+            } else if (arg == "--save-baseline") {
+                saveBaselinePath = value;
+            } else if (arg == "--tolerance") {
+                tolerance = stod(value);
+            } else {
+                cerr << "Unknown option " << arg << endl;
+                return 1;
+            }
+        } catch (const exception&) {
+            cerr << "Bad value for " << arg << ": " << value << endl;
+            return 1;
+        }
+    }
+    if (config.numProcesses <= 0 || config.meanCpuBurst <= 0 || config.ioRatio <= 0 || config.meanCpuBursts < 1 ||
+        config.load <= 0 || config.cpus <= 0 || quantum <= 0 || repeat <= 0) {
+        cerr << "Process count, burst sizes, load, CPU count, quantum and repeat count must be positive" << endl;
+        return 1;
+    }
+
+    const char* distributionNames[] = {"exponential", "bimodal", "heavy-tailed"};
+    ostringstream key;
+    key << "n=" << config.numProcesses << ",seed=" << config.seed << ",dist=" << distributionNames[config.distribution]
+        << ",burst=" << config.meanCpuBurst << ",io=" << config.ioRatio << ",bursts=" << config.meanCpuBursts
+        << ",load=" << config.load << ",q=" << quantum;
+    if (config.cpus > 1) {
+        key << ",cpus=" << config.cpus;
+    }
+    if (!deviceList.empty()) {
+        key << ",devices=" << deviceList;
+    }
+    string configKey = key.str();
+
+    auto generateStart = chrono::steady_clock::now();
+    Workload workload = generateWorkload(config);
+    double generateSeconds = chrono::duration<double>(chrono::steady_clock::now() - generateStart).count();
+    cout << "Workload " << configKey << ": " << workload.numProcesses << " processes, "
+         << workload.burstStreamSize << " burst bytes, generated in " << fixed << setprecision(1)
+         << generateSeconds * 1000 << " ms\n";
+
+    if (!outputPath.empty()) {
+        if (!writeBinaryTrace(workload, outputPath)) {
+            return 1;
+        }
+        cout << "Wrote trace to " << outputPath << "\n";
+    }
+
+    options.timeQuantum = quantum;
+    options.smp.cpus = config.cpus;
+    vector<BenchResult> results;
+    RunArena arena;
+    for (const char* algorithm : {"FIFO", "SJF", "SRTF", "CFS", "RR", "MLFQ", "LOTTERY", "STRIDE"}) {
+        BenchResult best;
+        best.algorithm = algorithm;
+        for (int run = 0; run < repeat; run++) {
+            RunArena::Scope scope(arena);
+            long long allocationsBefore = heapAllocations;
+            ProcessTable table(workload);
+            TraceSink silent(TRACE_OFF);
+            auto start = chrono::steady_clock::now();
+            runScheduler(algorithm, table, options, silent);
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            best.allocations = heapAllocations - allocationsBefore;
+            if (run == 0 || seconds < best.seconds) {
+                best.seconds = seconds;
+                best.dispatches = table.dispatches;
+                best.events = table.events;
+            }
+        }
+        results.push_back(best);
+
+        // FIFO and SJF may have been computed analytically; make sure that
+        // agrees with the event loop
+        string difference;
+        if (checkAnalytic(algorithm, workload, difference) == ANALYTIC_DIFFERS) {
+            cerr << "Analytic " << algorithm << " differs from the event loop: " << difference << endl;
+            return 1;
+        }
+    }
+
+    map<string, double> baseline;
+    if (!baselinePath.empty()) {
+        baseline = loadBaseline(baselinePath, configKey);
+        if (baseline.empty()) {
+            cerr << "No baseline for this configuration in " << baselinePath << endl;
+        }
+    }
+
+    bool regressed = false;
+    cout << "\nAlgorithm\tTime (ms)\tDispatches\tEvents\t\tEvents/sec\tns/dispatch\tAllocs\tvs baseline\n";
+    for (const BenchResult& result : results) {
+        double eventsPerSec = (result.events + result.dispatches) / result.seconds;
+        double nsPerDispatch = result.seconds * 1e9 / max(1LL, result.dispatches);
+        cout << result.algorithm << "\t\t" << setprecision(1) << result.seconds * 1000 << "\t\t"
+             << result.dispatches << "\t" << result.events << "\t\t" << setprecision(0) << eventsPerSec << "\t"
+             << setprecision(1) << nsPerDispatch << "\t\t" << result.allocations << "\t";
+        auto reference = baseline.find(result.algorithm);
+        if (reference != baseline.end()) {
+            double change = nsPerDispatch / reference->second - 1;
+            cout << showpos << setprecision(1) << change * 100 << "%" << noshowpos;
+            if (change > tolerance) {
+                cout << " REGRESSION";
+                regressed = true;
+            }
+        } else {
+            cout << "-";
+        }
+        cout << "\n";
+    }
+    PROFILE_REPORT(cout);
+    cout << "\nPeak RSS: " << peakRssKb() << " KiB, run arena " << arena.capacity() / 1024 << " KiB" << endl;
+
+    if (!saveBaselinePath.empty()) {
+        ofstream out(saveBaselinePath, ios::app);
+        for (const BenchResult& result : results) {
+            out << configKey << " " << result.algorithm << " " << fixed << setprecision(1)
+                << result.seconds * 1e9 / max(1LL, result.dispatches) << " "
+                << setprecision(0) << (result.events + result.dispatches) / result.seconds << "\n";
+        }
+        if (!out) {
+            cerr << saveBaselinePath << ": write failed" << endl;
+            return 1;
+        }
+        cout << "Appended baseline to " << saveBaselinePath << endl;
+    }
+
+    return regressed ? 2 : 0;
+}
@@ -0,0 +1,169 @@
+#include "checkpoint.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include "schedulers.h"
+#include "workload.h"
+using namespace std;
+
+// Snapshot file layout: magic, version and byte-order mark as in binary
+// traces, the run key as a length and its bytes, then the state written by
+// the scheduler. Integers are in host byte order.
+const char SNAPSHOT_MAGIC[8] = {'S', 'C', 'H', 'E', 'D', 'C', 'K', 'P'};
+const uint32_t SNAPSHOT_VERSION = 5;
+const uint32_t SNAPSHOT_BYTE_ORDER_MARK = 0x01020304;
+
+volatile sig_atomic_t Checkpointer::interruptRequested = 0;
+
+void Checkpointer::onInterrupt(int) {
+    interruptRequested = 1;
+}
+
+void Checkpointer::saveTo(const string& snapshotPath, long long snapshotEvery) {
+    path = snapshotPath;
+    everyEvents = snapshotEvery;
+    nextSnapshot = snapshotEvery;
+    signal(SIGINT, onInterrupt);
+}
+
+bool Checkpointer::resumeFrom(const string& snapshotPath) {
+    resumedFrom = snapshotPath;
+    auto fail = [&](const string& message) {
+        cerr << snapshotPath << ": " << message << endl;
+        return false;
+    };
+
+    FILE* in = fopen(snapshotPath.c_str(), "rb");
+    if (!in) {
+        return fail(strerror(errno));
+    }
+    string contents;
+    char buffer[1 << 16];
+    size_t count;
+    while ((count = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+        contents.append(buffer, count);
+    }
+    bool readError = ferror(in);
+    fclose(in);
+    if (readError) {
+        return fail("read failed");
+    }
+
+    Snapshot file(move(contents));
+    char magic[8];
+    uint32_t version, byteOrderMark;
+    string key;
+    file.io(magic);
+    file.io(version);
+    file.io(byteOrderMark);
+    if (!file.ok() || memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) != 0) {
+        return fail("not a snapshot file");
+    }
+    if (byteOrderMark != SNAPSHOT_BYTE_ORDER_MARK) {
+        return fail("snapshot was written on a host with different byte order");
+    }
+    if (version != SNAPSHOT_VERSION) {
+        return fail("unsupported snapshot version " + to_string(version));
+    }
+    vector<char> keyBytes;
+    file.io(keyBytes);
+    if (!file.ok()) {
+        return fail("truncated snapshot");
+    }
+    if (string(keyBytes.begin(), keyBytes.end()) != runKey) {
+        return fail("snapshot is of a different run (" + string(keyBytes.begin(), keyBytes.end()) +
+                    "); resume with the same algorithm, options and workload");
+    }
+
+    pending = file.bytes().substr(sizeof(magic) + 2 * sizeof(uint32_t) + sizeof(uint64_t) + keyBytes.size());
+    if (pending.empty()) {
+        return fail("truncated snapshot");
+    }
+    return true;
+}
+
+// Written beside the target and renamed over it, so a crash mid-write
+// leaves the previous snapshot intact
+bool Checkpointer::writeFile(const string& state) {
+    Snapshot header;
+    char magic[8];
+    memcpy(magic, SNAPSHOT_MAGIC, sizeof(magic));
+    uint32_t version = SNAPSHOT_VERSION, byteOrderMark = SNAPSHOT_BYTE_ORDER_MARK;
+    vector<char> keyBytes(runKey.begin(), runKey.end());
+    header.io(magic);
+    header.io(version);
+    header.io(byteOrderMark);
+    header.io(keyBytes);
+
+    string temporary = path + ".tmp";
+    FILE* out = fopen(temporary.c_str(), "wb");
+    if (!out) {
+        cerr << temporary << ": " << strerror(errno) << endl;
+        return false;
+    }
+    fwrite(header.bytes().data(), 1, header.bytes().size(), out);
+    fwrite(state.data(), 1, state.size(), out);
+    bool ok = !ferror(out);
+    if (fclose(out) != 0 || !ok || rename(temporary.c_str(), path.c_str()) != 0) {
+        cerr << path << ": writing the snapshot failed" << endl;
+        remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+void Checkpointer::reportCorrupt() {
+    cerr << resumedFrom << ": corrupt snapshot" << endl;
+    failed = true;
+}
+
+// FNV-1a, enough to tell workloads apart
+static uint64_t hashBytes(uint64_t hash, const void* data, size_t bytes) {
+    const uint8_t* p = (const uint8_t*)data;
+    for (size_t i = 0; i < bytes; i++) {
+        hash = (hash ^ p[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+string describeRun(const string& algorithm, const SchedulerOptions& options, const Workload& workload) {
+    size_t n = workload.numProcesses;
+    uint64_t hash = 14695981039346656037ULL;
+    hash = hashBytes(hash, workload.arrivalTime, n * sizeof(int32_t));
+    hash = hashBytes(hash, workload.numCpuBursts, n * sizeof(int32_t));
+    hash = hashBytes(hash, workload.nice, n * sizeof(int8_t));
+    hash = hashBytes(hash, workload.tickets, n * sizeof(int32_t));
+    hash = hashBytes(hash, workload.device, n * sizeof(uint8_t));
+    hash = hashBytes(hash, workload.burstStream, workload.burstStreamSize);
+
+    ostringstream key;
+    key << algorithm;
+    if (usesTimeQuantum(algorithm)) {
+        key << " quantum=" << options.timeQuantum;
+        if (algorithm == "LOTTERY") {
+            key << " seed=" << options.lotterySeed;
+        }
+    } else if (algorithm == "CFS") {
+        key << " latency=" << options.cfs.schedLatency << " granularity=" << options.cfs.minGranularity;
+    } else if (algorithm == "MLFQ") {
+        key << " levels=" << options.mlfq.levels << " quanta=";
+        for (size_t i = 0; i < options.mlfq.quanta.size(); i++) {
+            key << (i ? "," : "") << options.mlfq.quanta[i];
+        }
+        key << " boost=" << options.mlfq.boostInterval;
+    }
+    if (options.smp.cpus > 1) {
+        key << " cpus=" << options.smp.cpus << " balance=" << options.smp.balanceInterval
+            << " migration=" << options.smp.migrationCost;
+    }
+    if (!options.devices.empty()) {
+        key << " devices=";
+        for (size_t i = 0; i < options.devices.size(); i++) {
+            key << (i ? "," : "") << options.devices[i].slots << (options.devices[i].discipline == IO_SSTF ? ":sstf" : ":fifo");
+        }
+    }
+    key << " processes=" << n << " workload=" << hex << hash;
+    return key.str();
+}
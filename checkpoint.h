@@ -0,0 +1,245 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <queue>
+#include <set>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+struct SchedulerOptions;
+struct Workload;
+
+// Byte image of the state of a run, written or read back field by field.
+// The same io() calls serve both directions, so each piece of state is
+// described once: plain values are copied as bytes, containers as a count
+// followed by their elements, and classes through their snapshot(Snapshot&)
+// member. Reading past the end, or a count that cannot fit the remaining
+// bytes, marks the snapshot failed instead of reading garbage.
+class Snapshot {
+public:
+    // An empty snapshot to write into
+    Snapshot() = default;
+    // A snapshot to read back from `data`
+    explicit Snapshot(std::string data) : buffer(std::move(data)), reading(true) {}
+
+    bool loading() const { return reading; }
+    bool ok() const { return !failed; }
+    bool atEnd() const { return position == buffer.size(); }
+    const std::string& bytes() const { return buffer; }
+    // For state that reads back inconsistent
+    void fail() { failed = true; }
+
+    template <typename T>
+    void io(T& value) {
+        if constexpr (std::is_trivially_copyable<T>::value) {
+            raw(&value, sizeof(T));
+        } else {
+            value.snapshot(*this);
+        }
+    }
+
+    template <typename A, typename B>
+    void io(std::pair<A, B>& value) {
+        io(value.first);
+        io(value.second);
+    }
+
+    template <typename... T>
+    void io(std::tuple<T...>& value) {
+        std::apply([this](T&... fields) { (io(fields), ...); }, value);
+    }
+
+    template <typename T, typename Allocator>
+    void io(std::vector<T, Allocator>& values) {
+        uint64_t count = values.size();
+        if (!ioCount(count)) {
+            return;
+        }
+        if constexpr (std::is_trivially_copyable<T>::value) {
+            values.resize(count);
+            raw(values.data(), count * sizeof(T));
+        } else {
+            if constexpr (std::is_default_constructible<T>::value) {
+                values.resize(count);
+            } else if (count != values.size()) {
+                failed = true; // Elements that cannot be created here must already be in place
+                return;
+            }
+            for (T& value : values) {
+                io(value);
+            }
+        }
+    }
+
+    template <typename T, typename Allocator>
+    void io(std::deque<T, Allocator>& values) {
+        uint64_t count = values.size();
+        if (!ioCount(count)) {
+            return;
+        }
+        if (reading) {
+            values.resize(count);
+        }
+        for (T& value : values) {
+            io(value);
+        }
+    }
+
+    template <typename T, typename Compare, typename Allocator>
+    void io(std::set<T, Compare, Allocator>& values) {
+        uint64_t count = values.size();
+        if (!ioCount(count)) {
+            return;
+        }
+        if (reading) {
+            values.clear();
+            for (uint64_t i = 0; i < count && !failed; i++) {
+                T value;
+                io(value);
+                values.insert(values.end(), value);
+            }
+        } else {
+            for (T value : values) {
+                io(value);
+            }
+        }
+    }
+
+    // Written in pop order, so the entries must be totally ordered for a
+    // restored queue to behave like the original
+    template <typename T, typename Container, typename Compare>
+    void io(std::priority_queue<T, Container, Compare>& queue) {
+        std::vector<T> entries;
+        if (reading) {
+            io(entries);
+            queue = std::priority_queue<T, Container, Compare>();
+            for (T& entry : entries) {
+                queue.push(entry);
+            }
+        } else {
+            for (auto copy = queue; !copy.empty(); copy.pop()) {
+                entries.push_back(copy.top());
+            }
+            io(entries);
+        }
+    }
+
+private:
+    std::string buffer;
+    size_t position = 0;
+    bool reading = false;
+    bool failed = false;
+
+    void raw(void* data, size_t bytes) {
+        if (!reading) {
+            buffer.append((const char*)data, bytes);
+        } else if (failed || bytes > buffer.size() - position) {
+            failed = true;
+            memset(data, 0, bytes);
+        } else {
+            memcpy(data, buffer.data() + position, bytes);
+            position += bytes;
+        }
+    }
+
+    // Every element takes at least a byte, so a corrupt count larger than
+    // the bytes left is caught before a container allocates for it
+    bool ioCount(uint64_t& count) {
+        raw(&count, sizeof(count));
+        if (reading && count > buffer.size() - position) {
+            failed = true;
+        }
+        return !failed;
+    }
+};
+
+// Periodic and on-demand snapshots of a single run. Each scheduler hands
+// step() a callable that passes every piece of its state to a Snapshot, at
+// the top of its loop where that state is complete. A snapshot is written
+// every `everyEvents` arrivals and I/O completions and when SIGINT arrives,
+// after which the run stops. A run started with resumeFrom() restores the
+// saved state at its first step instead and carries on from there.
+class Checkpointer {
+public:
+    // runKey identifies the algorithm, options and workload; a snapshot is
+    // only accepted by a run with the same key
+    explicit Checkpointer(std::string runKey) : runKey(std::move(runKey)) {}
+
+    // Write snapshots to path (replaced atomically) every everyEvents
+    // events, 0 for only on SIGINT, which is caught from now on
+    void saveTo(const std::string& path, long long everyEvents);
+
+    // Load and check a snapshot written by a run with the same key; problems
+    // go to stderr
+    bool resumeFrom(const std::string& path);
+
+    // Called at the top of every scheduling step with the run's event
+    // count, which resuming restores; false means stop the run
+    template <typename State>
+    bool step(const long long& events, State& state) {
+        if (pending.empty()) {
+            if (interruptRequested && !path.empty()) {
+                interrupted = write(state);
+                failed = !interrupted;
+                return false;
+            }
+            if (everyEvents > 0 && events >= nextSnapshot) {
+                nextSnapshot = events + everyEvents;
+                if (!write(state)) {
+                    failed = true;
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        Snapshot snapshot(std::move(pending));
+        pending.clear();
+        state(snapshot);
+        if (!snapshot.ok() || !snapshot.atEnd()) {
+            reportCorrupt();
+            return false;
+        }
+        nextSnapshot = everyEvents > 0 ? events + everyEvents : 0;
+        return true;
+    }
+
+    bool wasInterrupted() const { return interrupted; }
+    bool hasFailed() const { return failed; }
+    const std::string& snapshotPath() const { return path; }
+
+private:
+    std::string runKey;
+    std::string path;
+    long long everyEvents = 0;
+    long long nextSnapshot = 0;
+    std::string pending;     // State read by resumeFrom, restored at the first step
+    std::string resumedFrom; // For messages
+    bool interrupted = false;
+    bool failed = false;
+
+    static volatile std::sig_atomic_t interruptRequested;
+    static void onInterrupt(int);
+
+    template <typename State>
+    bool write(State& state) {
+        Snapshot snapshot;
+        state(snapshot);
+        return writeFile(snapshot.bytes());
+    }
+    bool writeFile(const std::string& state);
+    void reportCorrupt();
+};
+
+// Identifies a run for checkpointing: the algorithm, every option that
+// changes the schedule, and a fingerprint of the workload
+std::string describeRun(const std::string& algorithm, const SchedulerOptions& options, const Workload& workload);
+
+#endif
@@ -1,559 +1,661 @@
-
-
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
-#include <fstream>
 #include <vector>
-#include <queue>
 #include <string>
+#include <map>
+#include <memory>
+#include <set>
 #include <sstream>
-#include <algorithm>
-#include <numeric> // For std::accumulate
-#include <climits>
-#include <deque>  // Include deque header
-#include <algorithm>  // Include for std::min
+#include "analytic.h"
+#include "checkpoint.h"
+#include "profile.h"
+#include "ready_queue.h"
+#include "schedulers.h"
+#include "batch.h"
+#include "sweep.h"
+#include "timeline.h"
+#include "trace.h"
+#include "workload.h"
 using namespace std;
 
 
-struct Process {
-    int arrivalTime;
-    vector<int> cpuBursts;
-    vector<int> ioBursts;
-    int currentCpuBurst = 0;
-    int currentIoBurst = 0;
-    int completionTime = 0;
-    int totalCpuBurstTime=0;
-    int turnaroundTime = 0;
-    int waitingTime = 0;
-    bool inIO = false;
-    bool completed = false;
-    int ioCompletionTime = 0;
-    int remainingCpuBurst = 0; // For SJF and SRTF
-    int startTime = 0; // For CFS
-};
-
-// Read workload file
-vector<Process> readWorkloadFile(const string& filePath) {
-    ifstream infile(filePath);
-    vector<Process> processes;
-    string line;
-
-    while (getline(infile, line)) {
-        Process p;
-        istringstream iss(line);
-        int value;
-
-        iss >> p.arrivalTime;
-
-        bool isCpuBurst = true;
-        while (iss >> value && value != -1) {
-            if (isCpuBurst) {
-                p.cpuBursts.push_back(value);
-            } else {
-                p.ioBursts.push_back(value);
-            }
-            isCpuBurst = !isCpuBurst;
-        }
-
-        // Initialize remaining CPU burst for SJF and SRTF
-        p.remainingCpuBurst = accumulate(p.cpuBursts.begin(), p.cpuBursts.end(), 0);
-        
-        processes.push_back(p);
+void calculateAndPrintMetrics(const ProcessTable& table) {
+    const Workload& workload = table.workload;
+    const RunMetrics& metrics = table.metrics;
+    long long numProcesses = metrics.turnaround.count();
+    if (numProcesses == 0) {
+        cout << "\nNo processes to report on." << endl;
+        return;
     }
 
-    return processes;
-}
-
-// FIFO Scheduling
-void fifoScheduling(vector<Process>& processes) {
-    int currentTime = 0;
-    vector<int> readyQueue;
-    int numProcesses = processes.size();
-    int processesCompleted = 0;
-
-    while (processesCompleted < numProcesses) {
-        // Add new arrivals to the ready queue
-        for (int i = 0; i < numProcesses; i++) {
-            if (processes[i].arrivalTime <= currentTime && !processes[i].inIO && !processes[i].completed) {
-                if (find(readyQueue.begin(), readyQueue.end(), i) == readyQueue.end()) {
-                    readyQueue.push_back(i);
-                }
-            }
+    // Streaming runs hand each process's slot back when it completes, so
+    // only the aggregates are left
+    if (table.stream) {
+        cout << "\nProcesses completed: " << numProcesses << "\n";
+    } else {
+        cout << "\nProcess\tArrival Time\tTotalCpuBurst\tCompletion Time\tTAT\tWT\tRT\n";
+        for (int i = 0; i < table.size(); i++) {
+            SimTime turnaroundTime = table.completionTime[i] - workload.arrivalTime[i];
+            SimTime waitingTime = turnaroundTime - workload.totalCpuBurstTime[i];
+            SimTime responseTime = table.firstRunTime[i] - workload.arrivalTime[i];
+            cout << "P" << i + 1 << "\t"
+                 << workload.arrivalTime[i] << "\t\t"
+                 << workload.totalCpuBurstTime[i] << "\t\t"
+                 << table.completionTime[i] << "\t\t"
+                 << turnaroundTime << "\t"
+                 << waitingTime << "\t"
+                 << responseTime << "\n";
         }
+    }
 
-        // Check if any process has completed its I/O and is ready for the next CPU burst
-        for (int i = 0; i < numProcesses; i++) {
-            if (processes[i].inIO && processes[i].ioCompletionTime <= currentTime) {
-                readyQueue.push_back(i);
-                processes[i].inIO = false;
-            }
+    cout << "\nAverage Turnaround Time (ATAT): " << metrics.turnaround.mean() << endl;
+    cout << "Average Waiting Time (AWT): " << metrics.waiting.mean() << endl;
+    cout << "Average Response Time (ART): " << metrics.response.mean() << endl;
+
+    // Busy time over the time the CPUs were available
+    int cpus = table.cpuStats.empty() ? 1 : (int)table.cpuStats.size();
+    long long busyTime = metrics.cpuTime;
+    if (!table.cpuStats.empty()) {
+        busyTime = 0;
+        for (const CpuStats& stats : table.cpuStats) {
+            busyTime += stats.busyTime;
         }
+    }
+    double capacity = (double)metrics.makespan * cpus;
+    double idlePercent = capacity > 0 ? 100.0 * (capacity - busyTime) / capacity : 0;
+    double throughput = metrics.makespan > 0 ? (double)numProcesses / metrics.makespan : 0;
+    cout << "Context switches: " << metrics.contextSwitches << endl;
+    cout << "CPU idle: " << (long long)(idlePercent * 10 + 0.5) / 10.0 << "%" << endl;
+    cout << "Throughput: " << throughput << " processes per time unit" << endl;
+
+    cout << "\nMetric\t\tp50\tp95\tp99\tmax\n";
+    const pair<const char*, const StreamingHistogram*> distributions[] = {
+        {"TAT\t", &metrics.turnaround},
+        {"WT\t", &metrics.waiting},
+        {"RT\t", &metrics.response},
+        {"Burst WT", &metrics.burstWaiting},
+    };
+    for (const auto& [name, histogram] : distributions) {
+        cout << name << "\t" << histogram->percentile(50) << "\t" << histogram->percentile(95) << "\t"
+             << histogram->percentile(99) << "\t" << histogram->max() << "\n";
+    }
 
-        if (!readyQueue.empty()) {
-            int processID = readyQueue.front();
-            readyQueue.erase(readyQueue.begin());
+    // Multi-CPU runs: how busy each CPU was over the whole run
+    if (!table.cpuStats.empty()) {
+        SimTime makespan = metrics.makespan;
+        long long totalMigrations = 0;
+        cout << "\nCPU\tUtilization\tDispatches\tMigrations\n";
+        for (size_t c = 0; c < table.cpuStats.size(); c++) {
+            const CpuStats& stats = table.cpuStats[c];
+            double utilization = makespan > 0 ? 100.0 * stats.busyTime / makespan : 0;
+            cout << c << "\t" << (long long)(utilization * 10 + 0.5) / 10.0 << "%\t\t"
+                 << stats.dispatches << "\t\t" << stats.migrations << "\n";
+            totalMigrations += stats.migrations;
+        }
+        cout << "Total migrations: " << totalMigrations << endl;
+    }
 
-            Process& process = processes[processID];
-            cout << "Executing Process " << processID + 1 << ", CPU Burst " << process.currentCpuBurst + 1 << endl;
-            currentTime += process.cpuBursts[process.currentCpuBurst];
-            process.currentCpuBurst++;
+    // Runs with I/O devices: how busy each was and how long requests queued
+    if (!table.deviceStats.empty()) {
+        SimTime makespan = metrics.makespan;
+        cout << "\nDevice\tSlots\tQueue\tUtilization\tRequests\tQueueing: mean\tp95\tp99\tmax\n";
+        for (size_t d = 0; d < table.deviceStats.size(); d++) {
+            const IoDevice& device = table.devices[d];
+            const DeviceStats& stats = table.deviceStats[d];
+            double capacity = (double)makespan * device.slots;
+            double utilization = capacity > 0 ? 100.0 * stats.busyTime / capacity : 0;
+            cout << d << "\t" << device.slots << "\t" << (device.discipline == IO_SSTF ? "sstf" : "fifo") << "\t"
+                 << (long long)(utilization * 10 + 0.5) / 10.0 << "%\t\t" << stats.queueing.count() << "\t\t"
+                 << stats.queueing.mean() << "\t\t" << stats.queueing.percentile(95) << "\t"
+                 << stats.queueing.percentile(99) << "\t" << stats.queueing.max() << "\n";
+        }
+    }
+}
+void printUsage(const char* program) {
+    cerr << "Usage: " << program << " <scheduling-algorithm> <path-to-workload-description-file> [<Time Quantum>] [options]\n"
+         << "       " << program << " sweep <path-to-workload-description-file> [options]\n"
+         << "       " << program << " batch <directory-or-glob>... [options]\n"
+         << "       " << program << " convert <path-to-workload-description-file> <output-trace-file>\n"
+         << "Options:\n"
+         << "  --sched-latency N     CFS scheduling period (default 6)\n"
+         << "  --min-granularity N   CFS minimum slice and wakeup margin (default 1)\n"
+         << "  --mlfq-levels N       MLFQ priority levels, 1 to 64 (default 3)\n"
+         << "  --mlfq-quanta LIST    MLFQ quantum per level, top first, e.g. 2,4,8 (default)\n"
+         << "  --mlfq-boost N        time between MLFQ priority boosts, 0 for none (default 100)\n"
+         << "  --cpus N              simulate N CPUs with per-CPU run queues (default 1)\n"
+         << "  --balance-interval N  time between load-balancing passes, 0 for none (default 4)\n"
+         << "  --migration-cost N    extra CPU time after a process changes CPU (default 0)\n"
+         << "  --devices LIST        I/O devices, device 0 first: how many requests each serves at\n"
+         << "                        once, then :fifo (default) or :sstf, e.g. 1,4:sstf. Processes\n"
+         << "                        pick one with dev=N. Default: every I/O burst runs at once\n"
+         << "  --lottery-seed N      seed for LOTTERY's draws, 0 to 2^64-1 (default 1)\n"
+         << "  --analytic MODE       on (default) computes FIFO and SJF without the event loop when\n"
+         << "                        no process does I/O; off always simulates; check runs both and\n"
+         << "                        fails if they disagree\n"
+         << "  --algorithms A,B,...  sweep, batch: algorithms to run (default FIFO,SJF,SRTF,CFS,RR,MLFQ)\n"
+         << "  --quanta LIST         sweep, batch: quanta for RR, LOTTERY and STRIDE, e.g. 1-200 or\n"
+         << "                        2,4,8 (default 1-200 for sweep, 4 for batch)\n"
+         << "  --threads N           sweep, batch: worker threads (default one per core)\n"
+         << "  --in-flight N         batch: traces loaded but not yet reported at a time (default\n"
+         << "                        two per thread)\n"
+         << "  --trace LEVEL         off, summary, dispatch (default) or tick\n"
+         << "  --trace-format F      text (default), csv or jsonl\n"
+         << "  --trace-file PATH     write the dispatch trace to PATH instead of stdout\n"
+         << "  --input MODE          batch (default) loads the whole workload first; stream reads\n"
+         << "                        processes as they arrive, in constant memory. A path of -\n"
+         << "                        streams from stdin\n"
+         << "  --verify-trace MODE   on also decodes every burst of a binary trace as it loads; off\n"
+         << "                        (default) checks only per-process fields\n"
+         << "  --checkpoint PATH     snapshot the run to PATH on SIGINT, which then stops it\n"
+         << "  --checkpoint-every N  also snapshot every N arrivals and I/O completions\n"
+         << "  --resume PATH         continue the run saved in PATH\n"
+         << "  --timeline PATH       write a Gantt timeline of every CPU to PATH\n"
+         << "  --timeline-format F   chrome (default; trace-event JSON), csv or binary\n"
+         << "  --timeline-window N   at most one interval per CPU every N time units" << endl;
+}
 
-            if (process.currentCpuBurst < process.cpuBursts.size()) {
-                process.inIO = true;
-                process.ioCompletionTime = currentTime + process.ioBursts[process.currentIoBurst++];
-            } else {
-                process.completionTime = currentTime;
-                process.completed = true;
-                processesCompleted++;
-            }
-        } else {
-            int nextEventTime = INT_MAX;
-            for (int i = 0; i < numProcesses; i++) {
-                if (!processes[i].completed) {
-                    if (processes[i].arrivalTime > currentTime) {
-                        nextEventTime = min(nextEventTime, processes[i].arrivalTime);
-                    }
-                    if (processes[i].inIO) {
-                        nextEventTime = min(nextEventTime, processes[i].ioCompletionTime);
-                    }
-                }
-            }
+// Parse a strictly positive integer option value
+bool parsePositive(const string& text, int& value) {
+    try {
+        size_t used;
+        value = stoi(text, &used);
+        return used == text.size() && value > 0;
+    } catch (const exception&) {
+        return false;
+    }
+}
 
-            if (nextEventTime != INT_MAX) {
-                currentTime = nextEventTime;
-                cout << "No process ready at time " << currentTime << ". Advancing time." << endl;
-            }
-        }
+// Parse an integer option value that may be zero
+bool parseNonNegative(const string& text, int& value) {
+    try {
+        size_t used;
+        value = stoi(text, &used);
+        return used == text.size() && value >= 0;
+    } catch (const exception&) {
+        return false;
     }
+}
 
-    for (auto& process : processes) {
-        process.totalCpuBurstTime = accumulate(process.cpuBursts.begin(), process.cpuBursts.end(), 0);
-        process.turnaroundTime = process.completionTime - process.arrivalTime;
-        process.waitingTime = process.turnaroundTime - process.totalCpuBurstTime;
+// Parse a full 64-bit unsigned option value, such as a random seed;
+// strtoull alone would skip spaces and wrap a leading minus sign around
+bool parseUnsigned64(const string& text, uint64_t& value) {
+    if (text.empty() || !isdigit((unsigned char)text[0])) {
+        return false;
+    }
+    char* end;
+    errno = 0;
+    unsigned long long parsed = strtoull(text.c_str(), &end, 10);
+    if (errno == ERANGE || *end != '\0') {
+        return false;
     }
+    value = parsed;
+    return true;
 }
 
-// Shortest Job First (SJF)
-void sjfScheduling(vector<Process>& processes) {
-    int currentTime = 0;
-    vector<int> readyQueue;
-    vector<int> completedProcesses;
-    int numProcesses = processes.size();
-    int processesCompleted = 0;
-
-    while (processesCompleted < numProcesses) {
-        // Add new arrivals to the ready queue
-        for (int i = 0; i < numProcesses; i++) {
-            if (processes[i].arrivalTime <= currentTime && !processes[i].inIO && !processes[i].completed) {
-                if (find(readyQueue.begin(), readyQueue.end(), i) == readyQueue.end()) {
-                    readyQueue.push_back(i);
-                }
-            }
+// Parse a comma-separated list of algorithm names
+bool parseAlgorithmList(const string& text, vector<string>& algorithms) {
+    algorithms.clear();
+    stringstream list(text);
+    string algorithm;
+    while (getline(list, algorithm, ',')) {
+        if (!isKnownAlgorithm(algorithm)) {
+            cerr << "Unsupported scheduling algorithm " << algorithm << "!" << endl;
+            return false;
         }
+        algorithms.push_back(algorithm);
+    }
+    return true;
+}
 
-        // Check if any process has completed its I/O and is ready for the next CPU burst
-        for (int i = 0; i < numProcesses; i++) {
-            if (processes[i].inIO && processes[i].ioCompletionTime <= currentTime) {
-                readyQueue.push_back(i);
-                processes[i].inIO = false;
-            }
+int main(int argc, char* argv[]) {
+    const set<string> knownOptions = {
+        "sched-latency", "min-granularity", "mlfq-levels", "mlfq-quanta", "mlfq-boost",
+        "cpus", "balance-interval", "migration-cost",
+        "devices",
+        "lottery-seed",
+        "analytic",
+        "algorithms", "quanta", "threads", "in-flight",
+        "trace", "trace-format", "trace-file",
+        "input", "verify-trace",
+        "checkpoint", "checkpoint-every", "resume",
+        "timeline", "timeline-format", "timeline-window",
+    };
+
+    // Split "--name value" / "--name=value" options from the positional arguments
+    vector<string> args;
+    map<string, string> options;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg.rfind("--", 0) != 0) {
+            args.push_back(arg);
+            continue;
         }
-
-        if (!readyQueue.empty()) {
-            // Find the process with the shortest CPU burst
-            int shortestJobID = readyQueue[0];
-            for (int id : readyQueue) {
-                if (processes[id].cpuBursts[processes[id].currentCpuBurst] < processes[shortestJobID].cpuBursts[processes[shortestJobID].currentCpuBurst]) {
-                    shortestJobID = id;
-                }
-            }
-
-            readyQueue.erase(remove(readyQueue.begin(), readyQueue.end(), shortestJobID), readyQueue.end());
-
-            Process& process = processes[shortestJobID];
-            cout << "Executing Process " << shortestJobID + 1 << ", CPU Burst " << process.currentCpuBurst + 1 << endl;
-            currentTime += process.cpuBursts[process.currentCpuBurst];
-            process.currentCpuBurst++;
-
-            if (process.currentCpuBurst < process.cpuBursts.size()) {
-                process.inIO = true;
-                process.ioCompletionTime = currentTime + process.ioBursts[process.currentIoBurst++];
-            } else {
-                process.completionTime = currentTime;
-                process.completed = true;
-                processesCompleted++;
-            }
+        size_t eq = arg.find('=');
+        if (eq != string::npos) {
+            options[arg.substr(2, eq - 2)] = arg.substr(eq + 1);
+        } else if (i + 1 < argc) {
+            options[arg.substr(2)] = argv[++i];
         } else {
-            int nextEventTime = INT_MAX;
-            for (int i = 0; i < numProcesses; i++) {
-                if (!processes[i].completed) {
-                    if (processes[i].arrivalTime > currentTime) {
-                        nextEventTime = min(nextEventTime, processes[i].arrivalTime);
-                    }
-                    if (processes[i].inIO) {
-                        nextEventTime = min(nextEventTime, processes[i].ioCompletionTime);
-                    }
-                }
-            }
-
-            if (nextEventTime != INT_MAX) {
-                currentTime = nextEventTime;
-                cout << "No process ready at time " << currentTime << ". Advancing time." << endl;
-            }
+            cerr << "Missing value for option " << arg << endl;
+            return 1;
         }
     }
-
-    for (auto& process : processes) {
-        process.totalCpuBurstTime = accumulate(process.cpuBursts.begin(), process.cpuBursts.end(), 0);
-        process.turnaroundTime = process.completionTime - process.arrivalTime;
-        process.waitingTime = process.turnaroundTime - process.totalCpuBurstTime;
-    }
-}
-
-// Shortest Remaining Time First (SRTF)
-void srtfScheduling(vector<Process>& processes) {
-    int currentTime = 0;
-    vector<int> readyQueue;
-    int numProcesses = processes.size();
-    vector<int> remainingTime(numProcesses, 0);
-    int processesCompleted = 0;
-
-    // Initialize remaining times for the current burst
-    for (int i = 0; i < numProcesses; i++) {
-        if (!processes[i].cpuBursts.empty()) {
-            remainingTime[i] = processes[i].cpuBursts[processes[i].currentCpuBurst];
+    for (const auto& option : options) {
+        if (!knownOptions.count(option.first)) {
+            cerr << "Unknown option --" << option.first << endl;
+            printUsage(argv[0]);
+            return 1;
         }
     }
 
-    while (processesCompleted < numProcesses) {
-        // Add new arrivals to the ready queue
-        for (int i = 0; i < numProcesses; i++) {
-            if (processes[i].arrivalTime <= currentTime && !processes[i].inIO && !processes[i].completed) {
-                if (find(readyQueue.begin(), readyQueue.end(), i) == readyQueue.end()) {
-                    readyQueue.push_back(i);
-                }
-            }
+    // Convert a text workload (or an older binary trace) to the binary trace format
+    if (!args.empty() && args[0] == "convert") {
+        if (args.size() != 3) {
+            cerr << "Usage: " << argv[0] << " convert <path-to-workload-description-file> <output-trace-file>" << endl;
+            return 1;
         }
-
-        // Check if any process has completed its I/O and is ready for the next CPU burst
-        for (int i = 0; i < numProcesses; i++) {
-            if (processes[i].inIO && processes[i].ioCompletionTime <= currentTime) {
-                processes[i].inIO = false;
-                if (find(readyQueue.begin(), readyQueue.end(), i) == readyQueue.end()) {
-                    readyQueue.push_back(i);
-                }
-                // Update remaining time for the next CPU burst
-                if (processes[i].currentCpuBurst < processes[i].cpuBursts.size()) {
-                    remainingTime[i] = processes[i].cpuBursts[processes[i].currentCpuBurst];
-                }
-            }
+        Workload workload;
+        // The new trace is trusted by every later load, so check all of it
+        if (!readWorkloadFile(args[1], workload, true) || !writeBinaryTrace(workload, args[2])) {
+            return 1;
         }
+        cout << "Wrote " << workload.numProcesses << " processes to " << args[2] << endl;
+        return 0;
+    }
 
-        if (!readyQueue.empty()) {
-            // Find the process with the shortest remaining current CPU burst time
-            int shortestTimeID = readyQueue[0];
-            for (int id : readyQueue) {
-                if (remainingTime[id] < remainingTime[shortestTimeID]) {
-                    shortestTimeID = id;
-                }
-            }
-
-            Process& process = processes[shortestTimeID];
-            int timeSlice = min(remainingTime[shortestTimeID], 1); // Time slice of 1 for simplicity
-
-            cout << "Executing Process " << shortestTimeID + 1 << ", CPU Burst " << process.currentCpuBurst + 1 << " for " << timeSlice << " units\n";
-            currentTime += timeSlice;
-            remainingTime[shortestTimeID] -= timeSlice;
-
-            if (remainingTime[shortestTimeID] <= 0) {
-                process.currentCpuBurst++;
-                if (process.currentCpuBurst < process.cpuBursts.size()) {
-                    // Process goes to I/O
-                    process.inIO = true;
-                    process.ioCompletionTime = currentTime + process.ioBursts[process.currentIoBurst++];
-                    // Remove from ready queue
-                    readyQueue.erase(remove(readyQueue.begin(), readyQueue.end(), shortestTimeID), readyQueue.end());
-                } else {
-                    // Process is completed
-                    process.completionTime = currentTime;
-                    process.completed = true;
-                    processesCompleted++;
-                    readyQueue.erase(remove(readyQueue.begin(), readyQueue.end(), shortestTimeID), readyQueue.end());
-                }
-            }
-        } else {
-            // Advance time to the next event
-            int nextEventTime = INT_MAX;
-            for (int i = 0; i < numProcesses; i++) {
-                if (!processes[i].completed) {
-                    if (processes[i].arrivalTime > currentTime) {
-                        nextEventTime = min(nextEventTime, processes[i].arrivalTime);
-                    }
-                    if (processes[i].inIO) {
-                        nextEventTime = min(nextEventTime, processes[i].ioCompletionTime);
-                    }
-                }
-            }
+    // batch takes any number of directories and globs
+    if (args.size() < 2 || (args[0] != "batch" && args.size() > 3)) {
+        printUsage(argv[0]);
+        return 1;
+    }
 
+    string schedulingAlgorithm = args[0];
+    string filePath = args[1];
 
-            if (nextEventTime != INT_MAX) {
-                currentTime = nextEventTime;
-                cout << "No process ready at time " << currentTime << ". Advancing time." << endl;
-            }
-        }
+    SchedulerOptions schedulerOptions;
+    CfsConfig& cfsConfig = schedulerOptions.cfs;
+    if (options.count("sched-latency") && !parsePositive(options["sched-latency"], cfsConfig.schedLatency)) {
+        cerr << "--sched-latency must be a positive integer" << endl;
+        return 1;
     }
-
-    // Compute turnaround and waiting times
-    for (auto& process : processes) {
-        process.totalCpuBurstTime = accumulate(process.cpuBursts.begin(), process.cpuBursts.end(), 0);
-        process.turnaroundTime = process.completionTime - process.arrivalTime;
-        process.waitingTime = process.turnaroundTime - process.totalCpuBurstTime;
+    if (options.count("min-granularity") && !parsePositive(options["min-granularity"], cfsConfig.minGranularity)) {
+        cerr << "--min-granularity must be a positive integer" << endl;
+        return 1;
     }
-}
-
-// Completely Fair Scheduler (CFS)
-void cfsScheduling(vector<Process>& processes) {
-    int currentTime = 0;
-    vector<int> readyQueue;
-    int numProcesses = processes.size();
-    int processesCompleted = 0;
-    const int timeSlice = 1; // CFS time slice
-
-    while (processesCompleted < numProcesses) {
-        // Add new arrivals to the ready queue
-        for (int i = 0; i < numProcesses; i++) {
-            if (processes[i].arrivalTime <= currentTime && !processes[i].inIO && !processes[i].completed) {
-                if (find(readyQueue.begin(), readyQueue.end(), i) == readyQueue.end()) {
-                    readyQueue.push_back(i);
-                }
+    MlfqConfig& mlfqConfig = schedulerOptions.mlfq;
+    if (options.count("mlfq-quanta")) {
+        mlfqConfig.quanta.clear();
+        stringstream list(options["mlfq-quanta"]);
+        string item;
+        int quantum;
+        while (getline(list, item, ',')) {
+            if (!parsePositive(item, quantum)) {
+                cerr << "--mlfq-quanta must be a list of positive integers, e.g. 2,4,8" << endl;
+                return 1;
             }
+            mlfqConfig.quanta.push_back(quantum);
         }
-
-        // Check if any process has completed its I/O and is ready for the next CPU burst
-        for (int i = 0; i < numProcesses; i++) {
-            if (processes[i].inIO && processes[i].ioCompletionTime <= currentTime) {
-                readyQueue.push_back(i);
-                processes[i].inIO = false;
-            }
+        if (mlfqConfig.quanta.empty()) {
+            cerr << "--mlfq-quanta must be a list of positive integers, e.g. 2,4,8" << endl;
+            return 1;
         }
-
-        if (!readyQueue.empty()) {
-            int processID = readyQueue.front();
-            readyQueue.erase(readyQueue.begin());
-
-            Process& process = processes[processID];
-            int burstTime = process.cpuBursts[process.currentCpuBurst];
-            int slice = min(burstTime, timeSlice);
-
-            cout << "Executing Process " << processID + 1 << ", CPU Burst " << process.currentCpuBurst + 1 << " for " << slice << " units\n";
-            currentTime += slice;
-            process.cpuBursts[process.currentCpuBurst] -= slice;
-
-            if (process.cpuBursts[process.currentCpuBurst] == 0) {
-                process.currentCpuBurst++;
-                if (process.currentCpuBurst < process.cpuBursts.size()) {
-                    process.inIO = true;
-                    process.ioCompletionTime = currentTime + process.ioBursts[process.currentIoBurst++];
-                } else {
-                    process.completionTime = currentTime;
-                    process.completed = true;
-                    processesCompleted++;
-                }
-            } else {
-                readyQueue.push_back(processID);
-            }
-        } else {
-            int nextEventTime = INT_MAX;
-            for (int i = 0; i < numProcesses; i++) {
-                if (!processes[i].completed) {
-                    if (processes[i].arrivalTime > currentTime) {
-                        nextEventTime = min(nextEventTime, processes[i].arrivalTime);
-                    }
-                    if (processes[i].inIO) {
-                        nextEventTime = min(nextEventTime, processes[i].ioCompletionTime);
-                    }
-                }
-            }
-
-            if (nextEventTime != INT_MAX) {
-                currentTime = nextEventTime;
-                cout << "No process ready at time " << currentTime << ". Advancing time." << endl;
-            }
+        mlfqConfig.levels = (int)mlfqConfig.quanta.size();
+    }
+    if (options.count("mlfq-levels")) {
+        if (!parsePositive(options["mlfq-levels"], mlfqConfig.levels) || mlfqConfig.levels > LevelQueue::MAX_LEVELS) {
+            cerr << "--mlfq-levels must be between 1 and " << LevelQueue::MAX_LEVELS << endl;
+            return 1;
+        }
+        if (!options.count("mlfq-quanta")) {
+            // Fewer levels than the defaults keep the top ones' quanta
+            mlfqConfig.quanta.resize(min<size_t>(mlfqConfig.quanta.size(), mlfqConfig.levels));
+        } else if (mlfqConfig.quanta.size() > (size_t)mlfqConfig.levels) {
+            cerr << "--mlfq-quanta has more entries than --mlfq-levels" << endl;
+            return 1;
         }
     }
-
-    for (auto& process : processes) {
-        process.totalCpuBurstTime = accumulate(process.cpuBursts.begin(), process.cpuBursts.end(), 0);
-        process.turnaroundTime = process.completionTime - process.arrivalTime;
-        process.waitingTime = process.turnaroundTime - process.totalCpuBurstTime;
+    if (options.count("mlfq-boost") && !parseNonNegative(options["mlfq-boost"], mlfqConfig.boostInterval)) {
+        cerr << "--mlfq-boost must be a non-negative integer" << endl;
+        return 1;
+    }
+    SmpConfig& smpConfig = schedulerOptions.smp;
+    if (options.count("cpus") && !parsePositive(options["cpus"], smpConfig.cpus)) {
+        cerr << "--cpus must be a positive integer" << endl;
+        return 1;
+    }
+    if (options.count("balance-interval") && !parseNonNegative(options["balance-interval"], smpConfig.balanceInterval)) {
+        cerr << "--balance-interval must be a non-negative integer" << endl;
+        return 1;
+    }
+    if (options.count("migration-cost") && !parseNonNegative(options["migration-cost"], smpConfig.migrationCost)) {
+        cerr << "--migration-cost must be a non-negative integer" << endl;
+        return 1;
     }
-}
-
-
-
-#include <deque>
-#include <algorithm>
-
-void roundRobinScheduling(vector<Process>& processes, int timeQuantum) {
-    int currentTime = 0;
-    deque<int> readyQueue;
-    int numProcesses = processes.size();
-    vector<int> remainingTime(numProcesses, 0);
-    int processesCompleted = 0;
 
-    // Initialize remaining times
-    for (int i = 0; i < numProcesses; i++) {
-        remainingTime[i] = accumulate(processes[i].cpuBursts.begin(), processes[i].cpuBursts.end(), 0);
+    if (options.count("devices") && !parseDeviceList(options["devices"], schedulerOptions.devices)) {
+        cerr << "--devices must be a list of positive slot counts, each optionally followed by :fifo or :sstf, "
+                "with at most " << MAX_DEVICES << " devices" << endl;
+        return 1;
     }
 
-    // Add initial process arrivals to the ready queue
-    for (int i = 0; i < numProcesses; i++) {
-        if (processes[i].arrivalTime <= currentTime) {
-            readyQueue.push_back(i);
+    if (options.count("lottery-seed")) {
+        if (!parseUnsigned64(options["lottery-seed"], schedulerOptions.lotterySeed)) {
+            cerr << "--lottery-seed must be an integer from 0 to 18446744073709551615" << endl;
+            return 1;
         }
     }
 
-    while (processesCompleted < numProcesses) {
-        if (!readyQueue.empty()) {
-            int processID = readyQueue.front();
-            readyQueue.pop_front();
-            Process& process = processes[processID];
-            int burstTime = process.cpuBursts[process.currentCpuBurst];
-            int timeSlice = min(burstTime, timeQuantum);
+    string analyticMode = options.count("analytic") ? options["analytic"] : "on";
+    if (analyticMode != "on" && analyticMode != "off" && analyticMode != "check") {
+        cerr << "--analytic must be one of on, off, check" << endl;
+        return 1;
+    }
+    schedulerOptions.analytic = analyticMode != "off";
 
-            cout << "Executing Process " << processID + 1 << ", CPU Burst " << process.currentCpuBurst + 1 << " for " << timeSlice << " units\n";
-            currentTime += timeSlice;
-            remainingTime[processID] -= timeSlice;
-            burstTime -= timeSlice;
+    string verifyMode = options.count("verify-trace") ? options["verify-trace"] : "off";
+    if (verifyMode != "on" && verifyMode != "off") {
+        cerr << "--verify-trace must be on or off" << endl;
+        return 1;
+    }
+    bool verifyTrace = verifyMode == "on";
 
-            if (burstTime > 0) {
-                process.cpuBursts[process.currentCpuBurst] = burstTime;
-                readyQueue.push_back(processID);
-            } else {
-                process.currentCpuBurst++;
-                if (process.currentCpuBurst < process.cpuBursts.size()) {
-                    process.inIO = true;
-                    process.ioCompletionTime = currentTime + process.ioBursts[process.currentIoBurst++];
-                } else {
-                    process.completionTime = currentTime;
-                    process.completed = true;
-                    processesCompleted++;
-                }
+    // Run every algorithm and time quantum on one trace
+    if (schedulingAlgorithm == "sweep") {
+        if (args.size() != 2) {
+            cerr << "Usage: " << argv[0] << " sweep <path-to-workload-description-file> [options]" << endl;
+            return 1;
+        }
+        if (options.count("input") && options["input"] != "batch") {
+            cerr << "sweep runs the workload many times and needs --input batch" << endl;
+            return 1;
+        }
+        if (options.count("checkpoint") || options.count("resume")) {
+            cerr << "sweep runs cannot be checkpointed" << endl;
+            return 1;
+        }
+        if (options.count("timeline")) {
+            cerr << "--timeline records a single run, not a sweep" << endl;
+            return 1;
+        }
+        if (analyticMode == "check") {
+            cerr << "--analytic check verifies a single run, not a sweep" << endl;
+            return 1;
+        }
+        SweepOptions sweepOptions;
+        sweepOptions.scheduler = schedulerOptions;
+        if (options.count("algorithms") && !parseAlgorithmList(options["algorithms"], sweepOptions.algorithms)) {
+            return 1;
+        }
+        if (!parseQuantumList(options.count("quanta") ? options["quanta"] : "1-200", sweepOptions.quanta)) {
+            cerr << "--quanta must be a list of positive integers or ranges, e.g. 1-200 or 2,4,8" << endl;
+            return 1;
+        }
+        int threads;
+        if (options.count("threads")) {
+            if (!parsePositive(options["threads"], threads)) {
+                cerr << "--threads must be a positive integer" << endl;
+                return 1;
             }
+            sweepOptions.threads = threads;
+        }
 
-            // Check for any processes that have arrived in the meantime
-            for (int i = 0; i < numProcesses; i++) {
-                if (processes[i].arrivalTime <= currentTime && !processes[i].completed && !processes[i].inIO) {
-                    if (find(readyQueue.begin(), readyQueue.end(), i) == readyQueue.end()) {
-                        readyQueue.push_back(i);
-                    }
-                }
+        Workload workload;
+        {
+            PROFILE_SCOPE(PHASE_PARSE);
+            if (!readWorkloadFile(filePath, workload, verifyTrace)) {
+                return 1;
             }
+        }
+        string deviceError;
+        if (!checkDevices(workload, schedulerOptions, deviceError)) {
+            cerr << filePath << ": " << deviceError << endl;
+            return 1;
+        }
+        runSweep(workload, sweepOptions, cout);
+        PROFILE_REPORT(cerr);
+        return 0;
+    }
 
-            // Check for processes completing their I/O and moving back to the ready queue
-            for (int i = 0; i < numProcesses; i++) {
-                if (processes[i].inIO && processes[i].ioCompletionTime <= currentTime) {
-                    processes[i].inIO = false;
-                    readyQueue.push_back(i);
-                }
+    // Run every algorithm on many traces, streaming them through a bounded pipeline
+    if (schedulingAlgorithm == "batch") {
+        if (options.count("input") && options["input"] != "batch") {
+            cerr << "batch loads each workload whole and needs --input batch" << endl;
+            return 1;
+        }
+        if (options.count("checkpoint") || options.count("resume")) {
+            cerr << "batch runs cannot be checkpointed" << endl;
+            return 1;
+        }
+        if (options.count("timeline") || options.count("trace-file")) {
+            cerr << "--timeline and --trace-file record a single run, not a batch" << endl;
+            return 1;
+        }
+        if (analyticMode == "check") {
+            cerr << "--analytic check verifies a single run, not a batch" << endl;
+            return 1;
+        }
+        BatchOptions batchOptions;
+        batchOptions.scheduler = schedulerOptions;
+        batchOptions.verifyTraces = verifyTrace;
+        if (options.count("algorithms") && !parseAlgorithmList(options["algorithms"], batchOptions.algorithms)) {
+            return 1;
+        }
+        if (options.count("quanta") && !parseQuantumList(options["quanta"], batchOptions.quanta)) {
+            cerr << "--quanta must be a list of positive integers or ranges, e.g. 1-200 or 2,4,8" << endl;
+            return 1;
+        }
+        int threads;
+        if (options.count("threads")) {
+            if (!parsePositive(options["threads"], threads)) {
+                cerr << "--threads must be a positive integer" << endl;
+                return 1;
             }
-        } else {
-            // Advance time to the next process arrival or I/O completion
-            int nextEventTime = INT_MAX;
-            for (int i = 0; i < numProcesses; i++) {
-                if (!processes[i].completed) {
-                    if (processes[i].arrivalTime > currentTime) {
-                        nextEventTime = min(nextEventTime, processes[i].arrivalTime);
-                    }
-                    if (processes[i].inIO) {
-                        nextEventTime = min(nextEventTime, processes[i].ioCompletionTime);
-                    }
-                }
+            batchOptions.threads = threads;
+        }
+        int inFlight;
+        if (options.count("in-flight")) {
+            if (!parsePositive(options["in-flight"], inFlight)) {
+                cerr << "--in-flight must be a positive integer" << endl;
+                return 1;
             }
+            batchOptions.inFlight = inFlight;
+        }
 
-            if (nextEventTime != INT_MAX) {
-                currentTime = nextEventTime;
-                cout << "No process ready at time " << currentTime << ". Advancing time." << endl;
-            } else {
-                break; // All processes are completed, so we exit the loop
-            }
+        vector<string> files;
+        if (!listWorkloadFiles(vector<string>(args.begin() + 1, args.end()), files)) {
+            return 1;
         }
+        bool loaded = runBatch(files, batchOptions, cout);
+        PROFILE_REPORT(cerr);
+        return loaded ? 0 : 1;
     }
 
-    // Calculate turnaround and waiting times
-    for (auto& process : processes) {
-        int totalCpuBurstTime = accumulate(process.cpuBursts.begin(), process.cpuBursts.end(), 0);
-        process.turnaroundTime = process.completionTime - process.arrivalTime;
-        process.waitingTime = process.turnaroundTime - totalCpuBurstTime;
+    if (usesTimeQuantum(schedulingAlgorithm)) {
+        if (args.size() != 3) {
+            cerr << "Usage: " << argv[0] << " <scheduling-algorithm> <path-to-workload-description-file> <Time Quantum>" << endl;
+            return 1;
+        }
+        // Convert the third argument to an integer for the time quantum
+        if (!parsePositive(args[2], schedulerOptions.timeQuantum)) {
+            cerr << "Time Quantum must be a positive integer" << endl;
+            return 1;
+        }
+    } else {
+        if (args.size() != 2) {
+            cerr << "Usage: " << argv[0] << " <scheduling-algorithm> <path-to-workload-description-file>" << endl;
+            return 1;
+        }
     }
-}
 
+    if (!isKnownAlgorithm(schedulingAlgorithm)) {
+        cerr << "Unsupported scheduling algorithm!" << endl;
+        return 1;
+    }
 
-
-void calculateAndPrintMetrics(const vector<Process>& processes) {
-    double totalTAT = 0, totalWT = 0;
-    int numProcesses = processes.size();
-
-    cout << "\nProcess\tArrival Time\tTotalCpuBurst\tCompletion Time\tTAT\tWT\n";
-    for (const auto& process : processes) {
-        cout << "P" << (&process - &processes[0]) + 1 << "\t"
-             << process.arrivalTime << "\t\t"
-             << process.totalCpuBurstTime <<"\t\t"
-             << process.completionTime << "\t\t"
-             << process.turnaroundTime << "\t"
-             << process.waitingTime << "\n";
-            
-
-        totalTAT += process.turnaroundTime;
-        totalWT += process.waitingTime;
+    TraceLevel traceLevel = TRACE_DISPATCH;
+    TraceFormat traceFormat = TRACE_TEXT;
+    if (options.count("trace") && !parseTraceLevel(options["trace"], traceLevel)) {
+        cerr << "--trace must be one of off, summary, dispatch, tick" << endl;
+        return 1;
+    }
+    if (options.count("trace-format") && !parseTraceFormat(options["trace-format"], traceFormat)) {
+        cerr << "--trace-format must be one of text, csv, jsonl" << endl;
+        return 1;
+    }
+    bool streaming = filePath == "-";
+    if (options.count("input")) {
+        if (options["input"] != "batch" && options["input"] != "stream") {
+            cerr << "--input must be batch or stream" << endl;
+            return 1;
+        }
+        if (options["input"] == "batch" && streaming) {
+            cerr << "stdin can only be read with --input stream" << endl;
+            return 1;
+        }
+        streaming = options["input"] == "stream";
     }
 
-    double averageTAT = totalTAT / numProcesses;
-    double averageWT = totalWT / numProcesses;
+    int checkpointEvery = 0;
+    if (options.count("checkpoint-every") &&
+        (!options.count("checkpoint") || !parsePositive(options["checkpoint-every"], checkpointEvery))) {
+        cerr << "--checkpoint-every must be a positive integer and needs --checkpoint" << endl;
+        return 1;
+    }
+    if (streaming && (options.count("checkpoint") || options.count("resume"))) {
+        cerr << "checkpoints need the whole workload; use --input batch" << endl;
+        return 1;
+    }
+    if (analyticMode == "check" &&
+        ((schedulingAlgorithm != "FIFO" && schedulingAlgorithm != "SJF") || smpConfig.cpus > 1 || streaming)) {
+        cerr << "--analytic check applies to FIFO and SJF on one CPU with --input batch" << endl;
+        return 1;
+    }
 
-    cout << "\nAverage Turnaround Time (ATAT): " << averageTAT << endl;
-    cout << "Average Waiting Time (AWT): " << averageWT << endl;
-}
-int main(int argc, char* argv[]) {
-    if (argc != 3 && argc != 4) {
-        cerr << "Usage: " << argv[0] << " <scheduling-algorithm> <path-to-workload-description-file> [<Time Quantum>]" << endl;
+    TimelineFormat timelineFormat = TIMELINE_CHROME;
+    int timelineWindow = 0;
+    if ((options.count("timeline-format") || options.count("timeline-window")) && !options.count("timeline")) {
+        cerr << "--timeline-format and --timeline-window need --timeline" << endl;
+        return 1;
+    }
+    if (options.count("timeline-format") && !parseTimelineFormat(options["timeline-format"], timelineFormat)) {
+        cerr << "--timeline-format must be one of chrome, csv, binary" << endl;
+        return 1;
+    }
+    if (options.count("timeline-window") && !parsePositive(options["timeline-window"], timelineWindow)) {
+        cerr << "--timeline-window must be a positive integer" << endl;
         return 1;
     }
 
-    string schedulingAlgorithm = argv[1];
-    string filePath = argv[2];
+    FILE* traceFile = nullptr;
+    if (options.count("trace-file")) {
+        traceFile = fopen(options["trace-file"].c_str(), "w");
+        if (!traceFile) {
+            cerr << options["trace-file"] << ": " << strerror(errno) << endl;
+            return 1;
+        }
+    }
 
-    int tq = 0;
-    if (schedulingAlgorithm == "RR") {
-        if (argc != 4) {
-            cerr << "Usage: " << argv[0] << " <scheduling-algorithm> <path-to-workload-description-file> <Time Quantum>" << endl;
+    // Streaming runs pull processes from the file (or stdin) as the clock
+    // reaches them instead of loading the workload up front
+    Workload workload;
+    WorkloadStream stream;
+    unique_ptr<ProcessTable> table;
+    if (streaming) {
+        PROFILE_SCOPE(PHASE_PARSE);
+        if (!schedulerOptions.devices.empty()) {
+            stream.limitDevices((int)schedulerOptions.devices.size());
+        }
+        if (!stream.open(filePath)) {
             return 1;
         }
-        tq = stoi(argv[3]);  // Convert the third argument to an integer for the time quantum
+        table.reset(new ProcessTable(stream));
     } else {
-        if (argc != 3) {
-            cerr << "Usage: " << argv[0] << " <scheduling-algorithm> <path-to-workload-description-file>" << endl;
+        PROFILE_SCOPE(PHASE_PARSE);
+        if (!readWorkloadFile(filePath, workload, verifyTrace)) {
+            return 1;
+        }
+        string deviceError;
+        if (!checkDevices(workload, schedulerOptions, deviceError)) {
+            cerr << filePath << ": " << deviceError << endl;
             return 1;
         }
+        table.reset(new ProcessTable(workload));
     }
 
-    vector<Process> processes = readWorkloadFile(filePath);
+    // Compare the analytic result with the event loop's before the run proper
+    if (analyticMode == "check") {
+        string difference;
+        AnalyticCheck check = checkAnalytic(schedulingAlgorithm, workload, difference);
+        if (check == ANALYTIC_DIFFERS) {
+            cerr << "Analytic " << schedulingAlgorithm << " differs from the event loop: " << difference << endl;
+            return 1;
+        }
+        cerr << (check == ANALYTIC_MATCHES ? "Analytic " + schedulingAlgorithm + " matches the event loop"
+                                           : "The workload does not qualify for analytic " + schedulingAlgorithm)
+             << endl;
+    }
 
-    if (schedulingAlgorithm == "FIFO") {
-        fifoScheduling(processes);
-    } else if (schedulingAlgorithm == "SJF") {
-        sjfScheduling(processes);
-    } else if (schedulingAlgorithm == "SRTF") {
-        srtfScheduling(processes);
-    } else if (schedulingAlgorithm == "CFS") {
-        cfsScheduling(processes);
-    } else if (schedulingAlgorithm == "RR") {
-        roundRobinScheduling(processes, tq);
-    } else {
-        cerr << "Unsupported scheduling algorithm!" << endl;
+    // Snapshots are tied to this algorithm, these options and this workload
+    unique_ptr<Checkpointer> checkpointer;
+    if (options.count("checkpoint") || options.count("resume")) {
+        checkpointer.reset(new Checkpointer(describeRun(schedulingAlgorithm, schedulerOptions, workload)));
+        if (options.count("resume") && !checkpointer->resumeFrom(options["resume"])) {
+            return 1;
+        }
+        if (options.count("checkpoint")) {
+            checkpointer->saveTo(options["checkpoint"], checkpointEvery);
+        }
+    }
+
+    // Sized for one interval per CPU burst, which run-to-completion policies
+    // need exactly
+    unique_ptr<Timeline> timeline;
+    if (options.count("timeline")) {
+        size_t bursts = 0;
+        for (size_t i = 0; i < workload.numProcesses; i++) {
+            bursts += workload.numCpuBursts[i];
+        }
+        timeline.reset(new Timeline(bursts));
+    }
+
+    {
+        TraceSink trace(traceLevel, traceFormat, traceFile ? traceFile : stdout);
+        if (streaming) {
+            trace.useProcessNumbers(&stream.processNumbers());
+        }
+        trace.recordTimeline(timeline.get());
+        runScheduler(schedulingAlgorithm, *table, schedulerOptions, trace, checkpointer.get());
+    }
+    if (traceFile) {
+        fclose(traceFile);
+    }
+    if (stream.failed() || (checkpointer && checkpointer->hasFailed())) {
         return 1;
     }
+    if (timeline) {
+        PROFILE_SCOPE(PHASE_TRACE);
+        if (timelineWindow > 0) {
+            *timeline = timeline->downsample(timelineWindow);
+        }
+        if (!timeline->write(options["timeline"], timelineFormat)) {
+            return 1;
+        }
+    }
+    if (checkpointer && checkpointer->wasInterrupted()) {
+        cerr << "Interrupted; the run was saved to " << checkpointer->snapshotPath() << " and continues with --resume "
+             << checkpointer->snapshotPath() << endl;
+        return 130;
+    }
 
-    calculateAndPrintMetrics(processes);
+    if (traceLevel >= TRACE_SUMMARY) {
+        PROFILE_SCOPE(PHASE_REPORT);
+        calculateAndPrintMetrics(*table);
+    }
+    PROFILE_REPORT(cerr);
 
     return 0;
 }
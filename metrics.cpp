@@ -0,0 +1,20 @@
+#include "metrics.h"
+
+#include <algorithm>
+#include <cmath>
+using namespace std;
+
+long long StreamingHistogram::percentile(double p) const {
+    if (total == 0) {
+        return 0;
+    }
+    long long rank = std::max(1LL, (long long)ceil(p / 100 * total));
+    long long seen = 0;
+    for (size_t index = 0; index < counts.size(); index++) {
+        seen += counts[index];
+        if (seen >= rank) {
+            return std::min(bucketMidpoint(index), maxValue);
+        }
+    }
+    return maxValue;
+}
@@ -0,0 +1,99 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "arena.h"
+#include "checkpoint.h"
+
+// Streaming histogram of non-negative integers in bounded memory, in the
+// style of HdrHistogram. Values below 256 are counted exactly; larger ones
+// fall into buckets 1/128 of their power of two wide, so any percentile is
+// within 0.8% of the true value and the whole histogram never exceeds about
+// 7000 counters, however many values are added.
+class StreamingHistogram {
+public:
+    void add(long long value) {
+        if (value < 0) {
+            value = 0;
+        }
+        size_t index = bucketOf(value);
+        if (index >= counts.size()) {
+            counts.resize(index + 1, 0);
+        }
+        counts[index]++;
+        total++;
+        sum += (double)value;
+        if (value > maxValue) {
+            maxValue = value;
+        }
+    }
+
+    long long count() const { return total; }
+    double mean() const { return total ? sum / total : 0; }
+    long long max() const { return maxValue; }
+
+    // Value at percentile p (0-100): the midpoint of the bucket holding it,
+    // or 0 if nothing was added
+    long long percentile(double p) const;
+
+    void snapshot(Snapshot& snapshot) {
+        snapshot.io(counts);
+        snapshot.io(total);
+        snapshot.io(sum);
+        snapshot.io(maxValue);
+    }
+
+private:
+    static const int SUB_BITS = 7; // Precision: 2^7 buckets per power of two
+
+    RunVector<long long> counts;
+    long long total = 0;
+    double sum = 0;
+    long long maxValue = 0;
+
+    static size_t bucketOf(long long value) {
+        if (value < (2LL << SUB_BITS)) {
+            return (size_t)value;
+        }
+        int exponent = 63 - __builtin_clzll((unsigned long long)value);
+        int shift = exponent - SUB_BITS;
+        return ((size_t)(shift + 1) << SUB_BITS) + (size_t)((value >> shift) - (1LL << SUB_BITS));
+    }
+
+    static long long bucketMidpoint(size_t index) {
+        if (index < (2u << SUB_BITS)) {
+            return (long long)index;
+        }
+        int shift = (int)(index >> SUB_BITS) - 1;
+        long long low = ((long long)(index & ((1u << SUB_BITS) - 1)) + (1LL << SUB_BITS)) << shift;
+        return low + ((1LL << shift) >> 1);
+    }
+};
+
+// Run-wide metrics accumulated while a run is simulated, so that nothing
+// has to be replayed or logged to report them
+struct RunMetrics {
+    StreamingHistogram turnaround;   // Per process, recorded at completion
+    StreamingHistogram waiting;      // Per process, recorded at completion
+    StreamingHistogram response;     // First dispatch minus arrival, per process
+    StreamingHistogram burstWaiting; // Ready to done minus the burst length, per CPU burst
+    long long contextSwitches = 0;   // A CPU started a process other than the one it ran last
+    long long cpuTime = 0;           // CPU time of the completed processes
+    long long makespan = 0;          // Completion time of the last process so far
+    RunVector<int> lastOnCpu;        // Process each CPU ran last, -1 if none yet
+
+    void snapshot(Snapshot& snapshot) {
+        snapshot.io(turnaround);
+        snapshot.io(waiting);
+        snapshot.io(response);
+        snapshot.io(burstWaiting);
+        snapshot.io(contextSwitches);
+        snapshot.io(cpuTime);
+        snapshot.io(makespan);
+        snapshot.io(lastOnCpu);
+    }
+};
+
+#endif
@@ -0,0 +1,220 @@
+#include "profile.h"
+
+#ifdef SCHED_PROFILE
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <mutex>
+#include <string>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+using namespace std;
+
+const int PROFILE_COUNTERS = 4;
+const char* const phaseNames[PHASE_COUNT] = {"other", "parse", "events", "select", "account", "trace", "report"};
+const uint64_t counterConfigs[PROFILE_COUNTERS] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                                   PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+
+struct PhaseTotals {
+    long long entries = 0;
+    long long nanoseconds = 0;
+    long long counts[PROFILE_COUNTERS] = {};
+
+    void add(const PhaseTotals& other) {
+        entries += other.entries;
+        nanoseconds += other.nanoseconds;
+        for (int i = 0; i < PROFILE_COUNTERS; i++) {
+            counts[i] += other.counts[i];
+        }
+    }
+};
+
+// Totals of the threads that have exited, and whether any of them could
+// open each counter
+static mutex finishedLock;
+static PhaseTotals finished[PHASE_COUNT];
+static bool finishedHasCounter[PROFILE_COUNTERS];
+static string counterProblem;
+
+// One thread's profile. The counters are opened as a group on first use,
+// so all of them are read with a single system call at each switch.
+class ThreadProfile {
+public:
+    ThreadProfile() {
+        openCounters();
+        sample(lastTime, lastCounts);
+    }
+
+    ~ThreadProfile() {
+        settle();
+        lock_guard<mutex> hold(finishedLock);
+        for (int p = 0; p < PHASE_COUNT; p++) {
+            finished[p].add(phases[p]);
+        }
+        for (int i = 0; i < PROFILE_COUNTERS; i++) {
+            finishedHasCounter[i] = finishedHasCounter[i] || slot[i] >= 0;
+        }
+        for (int fd : fds) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+    }
+
+    // Charge the time since the last switch to the current phase, then
+    // move to `phase`; returns the phase left
+    ProfilePhase enter(ProfilePhase phase) {
+        settle();
+        ProfilePhase left = current;
+        current = phase;
+        return left;
+    }
+
+    void countEntry(ProfilePhase phase) { phases[phase].entries++; }
+
+    // The totals so far, including the phase still open
+    void addTo(PhaseTotals* totals, bool* hasCounter) {
+        settle();
+        for (int p = 0; p < PHASE_COUNT; p++) {
+            totals[p].add(phases[p]);
+        }
+        for (int i = 0; i < PROFILE_COUNTERS; i++) {
+            hasCounter[i] = hasCounter[i] || slot[i] >= 0;
+        }
+    }
+
+private:
+    int fds[PROFILE_COUNTERS] = {-1, -1, -1, -1};
+    int slot[PROFILE_COUNTERS] = {-1, -1, -1, -1}; // Position of each counter in a group read, -1 if not open
+    int opened = 0;
+    ProfilePhase current = PHASE_OTHER;
+    long long lastTime = 0;
+    long long lastCounts[PROFILE_COUNTERS] = {};
+    PhaseTotals phases[PHASE_COUNT];
+
+    // User-mode counts of this thread only, which perf_event_paranoid 2
+    // still allows; the group leader is cycles
+    void openCounters() {
+        for (int i = 0; i < PROFILE_COUNTERS; i++) {
+            perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = counterConfigs[i];
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP;
+            int leader = fds[0];
+            int fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+            if (fd < 0) {
+                if (i == 0) {
+                    lock_guard<mutex> hold(finishedLock);
+                    counterProblem = strerror(errno);
+                    return;
+                }
+                continue;
+            }
+            fds[i] = fd;
+            slot[i] = opened++;
+        }
+    }
+
+    void sample(long long& time, long long* counts) {
+        time = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+        if (opened == 0) {
+            return;
+        }
+        uint64_t values[1 + PROFILE_COUNTERS];
+        if (read(fds[0], values, sizeof(values)) < (ssize_t)((1 + opened) * sizeof(uint64_t))) {
+            return;
+        }
+        for (int i = 0; i < PROFILE_COUNTERS; i++) {
+            if (slot[i] >= 0) {
+                counts[i] = (long long)values[1 + slot[i]];
+            }
+        }
+    }
+
+    void settle() {
+        long long time;
+        long long counts[PROFILE_COUNTERS];
+        memcpy(counts, lastCounts, sizeof(counts));
+        sample(time, counts);
+        PhaseTotals& phase = phases[current];
+        phase.nanoseconds += time - lastTime;
+        for (int i = 0; i < PROFILE_COUNTERS; i++) {
+            phase.counts[i] += counts[i] - lastCounts[i];
+        }
+        lastTime = time;
+        memcpy(lastCounts, counts, sizeof(counts));
+    }
+};
+
+static thread_local ThreadProfile profile;
+
+ProfileScope::ProfileScope(ProfilePhase phase) {
+    previous = profile.enter(phase);
+    profile.countEntry(phase);
+}
+
+ProfileScope::~ProfileScope() {
+    profile.enter(previous);
+}
+
+void writeProfile(ostream& out) {
+    PhaseTotals totals[PHASE_COUNT];
+    bool hasCounter[PROFILE_COUNTERS] = {};
+    profile.addTo(totals, hasCounter);
+    {
+        lock_guard<mutex> hold(finishedLock);
+        for (int p = 0; p < PHASE_COUNT; p++) {
+            totals[p].add(finished[p]);
+        }
+        for (int i = 0; i < PROFILE_COUNTERS; i++) {
+            hasCounter[i] = hasCounter[i] || finishedHasCounter[i];
+        }
+    }
+
+    long long totalNanoseconds = 0;
+    for (const PhaseTotals& phase : totals) {
+        totalNanoseconds += phase.nanoseconds;
+    }
+
+    auto counter = [&](const PhaseTotals& phase, int i) {
+        if (hasCounter[i]) {
+            out << "\t" << phase.counts[i];
+        } else {
+            out << "\t-";
+        }
+    };
+    out << "\nProfile\nPhase\tTime (ms)\tShare\tEntries\t\tCycles\t\tInstructions\tIPC\tCache misses\tBranch misses\n";
+    out << fixed;
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        const PhaseTotals& phase = totals[p];
+        double share = totalNanoseconds > 0 ? 100.0 * phase.nanoseconds / totalNanoseconds : 0;
+        out << phaseNames[p] << "\t" << setprecision(2) << phase.nanoseconds / 1e6 << "\t\t" << setprecision(1) << share
+            << "%\t" << phase.entries << "\t";
+        counter(phase, 0);
+        counter(phase, 1);
+        if (hasCounter[0] && hasCounter[1] && phase.counts[0] > 0) {
+            out << "\t" << setprecision(2) << (double)phase.counts[1] / phase.counts[0];
+        } else {
+            out << "\t-";
+        }
+        counter(phase, 2);
+        counter(phase, 3);
+        out << "\n";
+    }
+    out << defaultfloat;
+    if (!hasCounter[0]) {
+        lock_guard<mutex> hold(finishedLock);
+        out << "Hardware counters unavailable (perf_event_open: " << counterProblem << "); times only\n";
+    }
+}
+
+#endif
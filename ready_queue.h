@@ -0,0 +1,335 @@
+#ifndef READY_QUEUE_H
+#define READY_QUEUE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "arena.h"
+#include "checkpoint.h"
+
+// Indexed binary min-heap over process IDs. Every process is in the heap at
+// most once and its slot is tracked, so it can be removed without a linear
+// search.
+template <typename Key>
+class IndexedMinHeap {
+public:
+    explicit IndexedMinHeap(int numProcesses = 0) : position(numProcesses, -1) {}
+
+    bool empty() const { return ids.empty(); }
+    int size() const { return (int)ids.size(); }
+    bool contains(int processID) const { return position[processID] != -1; }
+
+    int top() const { return ids[0]; }
+    const Key& topKey() const { return keys[0]; }
+
+    void push(int processID, const Key& key) {
+        if ((size_t)processID >= position.size()) {
+            position.resize(processID + 1, -1); // Streaming runs add IDs as they go
+        }
+        int slot = (int)ids.size();
+        ids.push_back(processID);
+        keys.push_back(key);
+        position[processID] = slot;
+        siftUp(slot);
+    }
+
+    int pop() {
+        int processID = ids[0];
+        removeAt(0);
+        return processID;
+    }
+
+    void erase(int processID) {
+        removeAt(position[processID]);
+    }
+
+    void snapshot(Snapshot& snapshot) {
+        snapshot.io(ids);
+        snapshot.io(keys);
+        snapshot.io(position);
+    }
+
+private:
+    RunVector<int> ids;
+    RunVector<Key> keys;
+    RunVector<int> position; // Slot of each process in ids/keys, -1 if absent
+
+    void place(int slot, int processID, const Key& key) {
+        ids[slot] = processID;
+        keys[slot] = key;
+        position[processID] = slot;
+    }
+
+    void removeAt(int slot) {
+        position[ids[slot]] = -1;
+        int last = (int)ids.size() - 1;
+        if (slot != last) {
+            place(slot, ids[last], keys[last]);
+        }
+        ids.pop_back();
+        keys.pop_back();
+        if (slot < (int)ids.size()) {
+            siftDown(slot);
+            siftUp(slot);
+        }
+    }
+
+    void siftUp(int slot) {
+        int processID = ids[slot];
+        Key key = keys[slot];
+        while (slot > 0) {
+            int parent = (slot - 1) / 2;
+            if (!(key < keys[parent])) {
+                break;
+            }
+            place(slot, ids[parent], keys[parent]);
+            slot = parent;
+        }
+        place(slot, processID, key);
+    }
+
+    void siftDown(int slot) {
+        int count = (int)ids.size();
+        int processID = ids[slot];
+        Key key = keys[slot];
+        while (true) {
+            int child = 2 * slot + 1;
+            if (child >= count) {
+                break;
+            }
+            if (child + 1 < count && keys[child + 1] < keys[child]) {
+                child++;
+            }
+            if (!(keys[child] < key)) {
+                break;
+            }
+            place(slot, ids[child], keys[child]);
+            slot = child;
+        }
+        place(slot, processID, key);
+    }
+};
+
+// Ordering key for the shortest-burst policies: the burst length, with ties
+// going to whichever process entered the ready queue first.
+struct BurstKey {
+    int burst;
+    long long order;
+
+    bool operator<(const BurstKey& other) const {
+        return burst != other.burst ? burst < other.burst : order < other.order;
+    }
+};
+
+// Ordering key for stride scheduling: the pass value, with ties going to
+// whichever process entered the ready queue first.
+struct PassKey {
+    long long pass;
+    long long order;
+
+    bool operator<(const PassKey& other) const {
+        return pass != other.pass ? pass < other.pass : order < other.order;
+    }
+};
+
+// Fenwick (binary indexed) tree over the tickets of the processes waiting
+// for a lottery draw. Each process is placed by a key, its input order, and
+// the draw counts tickets in key order, so a streaming run, whose process
+// IDs are reused slots, picks the same process as a batch run. Entering a
+// process and taking out the holder of the k-th ticket both take O(log N),
+// so a draw stays cheap with hundreds of thousands of runnable processes.
+class TicketTree {
+public:
+    explicit TicketTree(int numProcesses = 0) { rebuild(0, numProcesses); }
+
+    long long total() const { return totalTickets; }
+
+    // Enter process `id`, holding `tickets`, into the draw under `key`
+    void insert(int key, int id, int tickets) {
+        if (key < first || (size_t)(key - first) >= held.size()) {
+            cover(key); // Streaming runs add keys as they go
+        }
+        size_t position = key - first;
+        held[position] = tickets;
+        holder[position] = id;
+        update(position, tickets);
+    }
+
+    // Take the holder of `ticket`, from 0 to total() - 1, out of the draw and
+    // return its ID: descend from the largest power-of-two prefix, skipping
+    // every prefix that ends before the ticket
+    int take(long long ticket) {
+        size_t position = 0;
+        for (size_t step = topStep; step > 0; step >>= 1) {
+            if (position + step < tree.size() && tree[position + step] <= ticket) {
+                position += step;
+                ticket -= tree[position];
+            }
+        }
+        update(position, -held[position]);
+        held[position] = 0;
+        return holder[position];
+    }
+
+    void snapshot(Snapshot& snapshot) {
+        snapshot.io(tree);
+        snapshot.io(held);
+        snapshot.io(holder);
+        snapshot.io(first);
+        snapshot.io(topStep);
+        snapshot.io(totalTickets);
+    }
+
+private:
+    RunVector<long long> tree; // 1-based; tree[i] sums held over (i - lowbit(i), i]
+    RunVector<int> held;       // Tickets under each key from `first` on, 0 if none
+    RunVector<int> holder;     // ID of the process under each key
+    int first = 0;             // Key of held[0]
+    size_t topStep = 0;        // Largest power of two that fits in held.size()
+    long long totalTickets = 0;
+
+    void update(size_t position, int delta) {
+        totalTickets += delta;
+        for (size_t i = position + 1; i < tree.size(); i += i & -i) {
+            tree[i] += delta;
+        }
+    }
+
+    // Move the window of keys to take in `key` as well as every key in the
+    // draw, dropping the keys below them that have left for good. The window
+    // is at least twice the keys it must span, so that streaming costs O(1)
+    // amortised per process; rebuilt in O(N)
+    void cover(int key) {
+        int low = key, high = key;
+        for (size_t i = 0; i < held.size(); i++) {
+            if (held[i]) {
+                low = std::min(low, first + (int)i);
+                high = std::max(high, first + (int)i);
+            }
+        }
+        rebuild(low, std::max(held.size(), 2 * (size_t)(high - low + 1)));
+    }
+
+    void rebuild(int newFirst, size_t size) {
+        RunVector<int> oldHeld(size, 0), oldHolder(size, 0);
+        oldHeld.swap(held);
+        oldHolder.swap(holder);
+        for (size_t i = 0; i < oldHeld.size(); i++) {
+            if (oldHeld[i]) {
+                held[first + i - newFirst] = oldHeld[i];
+                holder[first + i - newFirst] = oldHolder[i];
+            }
+        }
+        first = newFirst;
+        tree.assign(size + 1, 0);
+        for (size_t i = 1; i <= size; i++) {
+            tree[i] += held[i - 1];
+            size_t parent = i + (i & -i);
+            if (parent <= size) {
+                tree[parent] += tree[i];
+            }
+        }
+        topStep = 0;
+        for (size_t step = 1; step <= size; step *= 2) {
+            topStep = step;
+        }
+    }
+};
+
+// Next value of a SplitMix64 generator: small enough to checkpoint as one
+// integer, and the same sequence on every platform for a given seed
+inline uint64_t nextRandom(uint64_t& state) {
+    uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// Run queue with one FIFO list per priority level, level 0 being the
+// highest, as in the Linux O(1) scheduler. The lists are intrusive: they are
+// threaded through a per-process link array, which several queues may share
+// as long as each process is in at most one of them. A bitmap of the
+// non-empty levels finds the highest one with a single instruction, so
+// every operation is O(1) however deep the queues are.
+class LevelQueue {
+public:
+    static const int MAX_LEVELS = 64;
+
+    LevelQueue(int levels, RunVector<int>* links) : head(levels, -1), tail(levels, -1), links(links) {}
+
+    bool empty() const { return nonEmpty == 0; }
+    int size() const { return count; }
+    int highestLevel() const { return __builtin_ctzll(nonEmpty); }
+
+    void pushBack(int processID, int level) {
+        (*links)[processID] = -1;
+        if (tail[level] == -1) {
+            head[level] = processID;
+            nonEmpty |= bit(level);
+        } else {
+            (*links)[tail[level]] = processID;
+        }
+        tail[level] = processID;
+        count++;
+    }
+
+    void pushFront(int processID, int level) {
+        (*links)[processID] = head[level];
+        if (head[level] == -1) {
+            tail[level] = processID;
+            nonEmpty |= bit(level);
+        }
+        head[level] = processID;
+        count++;
+    }
+
+    // Remove the first process of the highest non-empty level
+    int pop() {
+        int level = highestLevel();
+        int processID = head[level];
+        head[level] = (*links)[processID];
+        if (head[level] == -1) {
+            tail[level] = -1;
+            nonEmpty &= ~bit(level);
+        }
+        count--;
+        return processID;
+    }
+
+    // Append every lower level to level 0, highest first, keeping each
+    // level's order
+    void mergeAll() {
+        for (int level = 1; level < (int)head.size(); level++) {
+            if (head[level] == -1) {
+                continue;
+            }
+            if (tail[0] == -1) {
+                head[0] = head[level];
+            } else {
+                (*links)[tail[0]] = head[level];
+            }
+            tail[0] = tail[level];
+            head[level] = tail[level] = -1;
+        }
+        nonEmpty = nonEmpty ? 1 : 0;
+    }
+
+    // The links belong to the caller and are saved with it
+    void snapshot(Snapshot& snapshot) {
+        snapshot.io(head);
+        snapshot.io(tail);
+        snapshot.io(nonEmpty);
+        snapshot.io(count);
+    }
+
+private:
+    RunVector<int> head;
+    RunVector<int> tail;
+    RunVector<int>* links; // Next process in the same list, -1 at the end
+    uint64_t nonEmpty = 0;   // Bit i set if level i has a process
+    int count = 0;
+
+    static uint64_t bit(int level) { return (uint64_t)1 << level; }
+};
+
+#endif
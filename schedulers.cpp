@@ -0,0 +1,505 @@
+#include "schedulers.h"
+
+#include <algorithm>
+#include <deque>
+#include <set>
+#include <sstream>
+#include <tuple>
+#include "analytic.h"
+#include "ready_queue.h"
+#include "simulate.h"
+#include "smp.h"
+using namespace std;
+
+// Each scheduler is a policy for the loop in simulate.h
+
+// First In First Out (FIFO): every CPU burst runs to the end, in the order
+// processes became ready
+class FifoPolicy : public PolicyDefaults {
+public:
+    FifoPolicy(ProcessTable& table, const SimTime&) : table(table) {}
+
+    bool empty() const { return queue.empty(); }
+    void enqueue(int id) { queue.push_back(id); }
+    int pickNext() {
+        int id = queue.front();
+        queue.pop_front();
+        return id;
+    }
+    SimTime sliceFor(int id) const { return table.remainingCpuBurst[id]; }
+    void snapshot(Snapshot& snapshot) { snapshot.io(queue); }
+
+private:
+    ProcessTable& table;
+    RunDeque<int> queue;
+};
+
+void fifoScheduling(ProcessTable& table, TraceSink& trace, Checkpointer* checkpointer) {
+    simulate<FifoPolicy>(table, trace, checkpointer);
+}
+
+// Shortest Job First (SJF), or Shortest Remaining Time First (SRTF) when
+// preemptive: the shortest burst left runs, ties going to whichever process
+// became ready first
+template <bool Preemptive>
+class ShortestBurstPolicy : public PolicyDefaults {
+public:
+    static constexpr bool preemptive = Preemptive;
+
+    ShortestBurstPolicy(ProcessTable& table, const SimTime&) : table(table), queue(table.size()) {}
+
+    bool empty() const { return queue.empty(); }
+    void enqueue(int id) { queue.push(id, {table.remainingCpuBurst[id], nextOrder++}); }
+    int pickNext() {
+        runningOrder = queue.topKey().order;
+        return queue.pop();
+    }
+    SimTime sliceFor(int id) const { return table.remainingCpuBurst[id]; }
+    bool shouldPreempt(int id) const {
+        return !queue.empty() && queue.topKey() < BurstKey{table.remainingCpuBurst[id], runningOrder};
+    }
+    // A preempted process keeps its place among equal remaining times
+    void requeue(int id) { queue.push(id, {table.remainingCpuBurst[id], runningOrder}); }
+    void snapshot(Snapshot& snapshot) {
+        snapshot.io(queue);
+        snapshot.io(nextOrder);
+        snapshot.io(runningOrder);
+    }
+
+private:
+    ProcessTable& table;
+    IndexedMinHeap<BurstKey> queue;
+    long long nextOrder = 0;
+    long long runningOrder = 0;
+};
+
+void sjfScheduling(ProcessTable& table, TraceSink& trace, Checkpointer* checkpointer) {
+    simulate<ShortestBurstPolicy<false>>(table, trace, checkpointer);
+}
+
+void srtfScheduling(ProcessTable& table, TraceSink& trace, Checkpointer* checkpointer) {
+    simulate<ShortestBurstPolicy<true>>(table, trace, checkpointer);
+}
+
+// Completely Fair Scheduler (CFS)
+
+// Load weight of each nice level from -20 to 19, as in the Linux scheduler
+const int niceToWeight[40] = {
+    88761, 71755, 56483, 46273, 36291,
+    29154, 23254, 18705, 14949, 11916,
+    9548,  7620,  6100,  4904,  3906,
+    3121,  2501,  1991,  1586,  1277,
+    1024,  820,   655,   526,   423,
+    335,   272,   215,   172,   137,
+    110,   87,    70,    56,    45,
+    36,    29,    23,    18,    15,
+};
+// vruntime is kept scaled up so that weighting a short run by a large
+// weight does not round down to zero
+const long long VRUNTIME_SCALE = 1024;
+
+int niceWeight(int nice) {
+    return niceToWeight[nice + 20];
+}
+
+long long weightedRuntime(long long delta, int weight) {
+    return delta * NICE_0_WEIGHT * VRUNTIME_SCALE / weight;
+}
+
+// Split the latency period across the runnable processes by weight
+long long cfsSlice(const CfsConfig& config, size_t waiting, int weight, long long runnableWeight) {
+    long long period = max<long long>(config.schedLatency, (long long)(waiting + 1) * config.minGranularity);
+    return max<long long>(config.minGranularity, period * weight / runnableWeight);
+}
+
+// At most half a latency period, so sleepers cannot monopolise the CPU
+long long cfsSleeperCredit(const CfsConfig& config) {
+    return weightedRuntime(config.schedLatency, NICE_0_WEIGHT) / 2;
+}
+
+bool cfsWakeupPreempts(const CfsConfig& config, long long leftmost, long long vruntime, int weight) {
+    return leftmost + weightedRuntime(config.minGranularity, weight) < vruntime;
+}
+
+// Runnable processes ordered by (vruntime, enqueue order); the running
+// process is kept out of the tree, as in Linux
+class CfsPolicy : public PolicyDefaults {
+public:
+    static constexpr bool preemptive = true;
+    static constexpr bool timeSliced = true;
+
+    CfsPolicy(ProcessTable& table, const SimTime&, const CfsConfig& config)
+        : table(table), config(config), vruntime(table.size(), 0) {}
+
+    bool empty() const { return timeline.empty(); }
+
+    // New processes start at min_vruntime; waking sleepers get at most half
+    // a latency period of credit so they cannot monopolise the CPU
+    void enqueue(int id) {
+        if (table.currentCpuBurst[id] == 0) {
+            coverProcesses(vruntime, table, 0LL);
+            vruntime[id] = minVruntime;
+        } else {
+            vruntime[id] = max(vruntime[id], minVruntime - cfsSleeperCredit(config));
+        }
+        runnableWeight += weightOf(id);
+        insert(id);
+    }
+
+    int pickNext() {
+        auto leftmost = timeline.begin();
+        int id = get<2>(*leftmost);
+        timeline.erase(leftmost);
+        sliceLeft = cfsSlice(config, timeline.size(), weightOf(id), runnableWeight);
+        return id;
+    }
+
+    // With nobody else runnable there is nothing to switch to, so the slice
+    // does not bound the run
+    SimTime sliceFor(int id) const {
+        SimTime remaining = table.remainingCpuBurst[id];
+        return timeline.empty() ? remaining : min<SimTime>(sliceLeft, remaining);
+    }
+
+    void charge(int id, SimTime ran) {
+        vruntime[id] += weightedRuntime(ran, weightOf(id));
+        sliceLeft -= ran;
+        long long leftmost = timeline.empty() ? vruntime[id] : min(vruntime[id], get<0>(*timeline.begin()));
+        minVruntime = max(minVruntime, leftmost);
+    }
+
+    void retire(int id) { runnableWeight -= weightOf(id); }
+
+    // Wakeup preemption: a process that is sufficiently far behind takes
+    // over the CPU
+    bool shouldPreempt(int id) const {
+        return !timeline.empty() && cfsWakeupPreempts(config, get<0>(*timeline.begin()), vruntime[id], weightOf(id));
+    }
+    void requeue(int id) { insert(id); }
+
+    bool expire(int id) {
+        if (sliceLeft > 0) {
+            return false;
+        }
+        if (timeline.empty()) {
+            sliceLeft = config.schedLatency;
+            return false;
+        }
+        insert(id);
+        return true;
+    }
+
+    void snapshot(Snapshot& snapshot) {
+        snapshot.io(timeline);
+        snapshot.io(vruntime);
+        snapshot.io(nextOrder);
+        snapshot.io(minVruntime);
+        snapshot.io(runnableWeight);
+        snapshot.io(sliceLeft);
+    }
+
+private:
+    ProcessTable& table;
+    const CfsConfig& config;
+    RunSet<tuple<long long, long long, int>> timeline;
+    RunVector<long long> vruntime;
+    long long nextOrder = 0;
+    long long minVruntime = 0;
+    long long runnableWeight = 0; // Waiting processes plus the running one
+    long long sliceLeft = 0;
+
+    int weightOf(int id) const { return niceWeight(table.workload.nice[id]); }
+    void insert(int id) { timeline.insert({vruntime[id], nextOrder++, id}); }
+};
+
+void cfsScheduling(ProcessTable& table, const CfsConfig& config, TraceSink& trace, Checkpointer* checkpointer) {
+    simulate<CfsPolicy>(table, trace, checkpointer, config);
+}
+
+// Round Robin (RR): FIFO order, at most one time quantum at a time
+class RoundRobinPolicy : public PolicyDefaults {
+public:
+    static constexpr bool timeSliced = true;
+
+    RoundRobinPolicy(ProcessTable& table, const SimTime&, int timeQuantum) : table(table), timeQuantum(timeQuantum) {}
+
+    bool empty() const { return queue.empty(); }
+    void enqueue(int id) { queue.push_back(id); }
+    int pickNext() {
+        int id = queue.front();
+        queue.pop_front();
+        return id;
+    }
+    SimTime sliceFor(int id) const { return min(table.remainingCpuBurst[id], timeQuantum); }
+    // The quantum ran out: back of the queue, ahead of whatever arrived or
+    // finished I/O during the slice
+    bool expire(int id) {
+        queue.push_back(id);
+        return true;
+    }
+    void snapshot(Snapshot& snapshot) { snapshot.io(queue); }
+
+private:
+    ProcessTable& table;
+    int timeQuantum;
+    RunDeque<int> queue;
+};
+
+void roundRobinScheduling(ProcessTable& table, int timeQuantum, TraceSink& trace, Checkpointer* checkpointer) {
+    simulate<RoundRobinPolicy>(table, trace, checkpointer, timeQuantum);
+}
+
+// Multi-Level Feedback Queue (MLFQ)
+class MlfqPolicy : public PolicyDefaults {
+public:
+    static constexpr bool preemptive = true;
+    static constexpr bool timeSliced = true;
+
+    MlfqPolicy(ProcessTable& table, const SimTime& now, const MlfqConfig& config)
+        : table(table), now(now), links(table.size()), queue(config.levels, &links), priorities(config, table.size()) {}
+
+    bool empty() const { return queue.empty(); }
+
+    // Priority boost: everything waiting moves to the top level
+    void beginStep() { applyBoost(); }
+
+    // New arrivals and finished I/O go to the back of their level
+    void enqueue(int id) {
+        if (table.currentCpuBurst[id] == 0) {
+            coverProcesses(links, table, -1);
+            priorities.admit(id);
+        }
+        queue.pushBack(id, levelOf(id));
+    }
+    int pickNext() { return queue.pop(); }
+
+    // Until the quantum or the burst ends
+    SimTime sliceFor(int id) {
+        levelOf(id);
+        return min<SimTime>(priorities.quantumLeft(id), table.remainingCpuBurst[id]);
+    }
+    void charge(int id, SimTime ran) { priorities.charge(id, ran); }
+    void retire(int id) { priorities.finishBurst(id); }
+
+    // A higher level became ready: the running process goes back to the
+    // front of its level, keeping what is left of its quantum
+    bool shouldPreempt(int id) { return !queue.empty() && queue.highestLevel() < levelOf(id); }
+    void requeue(int id) { queue.pushFront(id, levelOf(id)); }
+
+    // Used up its quantum: one level down, at the back
+    bool expire(int id) {
+        if (!priorities.quantumExpired(id)) {
+            return false;
+        }
+        applyBoost();
+        priorities.demote(id);
+        queue.pushBack(id, levelOf(id));
+        return true;
+    }
+
+    void snapshot(Snapshot& snapshot) {
+        snapshot.io(links);
+        snapshot.io(queue);
+        snapshot.io(priorities);
+        snapshot.io(queueEpoch);
+    }
+
+private:
+    ProcessTable& table;
+    const SimTime& now;
+    RunVector<int> links;
+    LevelQueue queue;
+    MlfqPriorities priorities;
+    long long queueEpoch = 0;
+
+    int levelOf(int id) { return priorities.levelOf(id, now); }
+    void applyBoost() {
+        if (priorities.boostEpoch(now) != queueEpoch) {
+            queueEpoch = priorities.boostEpoch(now);
+            queue.mergeAll();
+        }
+    }
+};
+
+void mlfqScheduling(ProcessTable& table, const MlfqConfig& config, TraceSink& trace, Checkpointer* checkpointer) {
+    simulate<MlfqPolicy>(table, trace, checkpointer, config);
+}
+
+// Lottery scheduling: each quantum goes to the holder of a ticket drawn at
+// random from those of the waiting processes, so over time every process
+// gets CPU in proportion to its tickets. The running process is kept out of
+// the ticket tree.
+class LotteryPolicy : public PolicyDefaults {
+public:
+    static constexpr bool timeSliced = true;
+
+    LotteryPolicy(ProcessTable& table, const SimTime&, int timeQuantum, uint64_t seed)
+        : table(table), timeQuantum(timeQuantum), tickets(table.size()), randomState(seed) {}
+
+    bool empty() const { return tickets.total() == 0; }
+    void enqueue(int id) { tickets.insert(table.processNumber(id), id, table.workload.tickets[id]); }
+    int pickNext() { return tickets.take((long long)(nextRandom(randomState) % (uint64_t)tickets.total())); }
+    SimTime sliceFor(int id) const { return min(table.remainingCpuBurst[id], timeQuantum); }
+    // The quantum ran out: back into the draw, which it may win again
+    bool expire(int id) {
+        enqueue(id);
+        return true;
+    }
+    void snapshot(Snapshot& snapshot) {
+        snapshot.io(tickets);
+        snapshot.io(randomState);
+    }
+
+private:
+    ProcessTable& table;
+    int timeQuantum;
+    TicketTree tickets;
+    uint64_t randomState;
+};
+
+void lotteryScheduling(ProcessTable& table, int timeQuantum, uint64_t seed, TraceSink& trace, Checkpointer* checkpointer) {
+    simulate<LotteryPolicy>(table, trace, checkpointer, timeQuantum, seed);
+}
+
+// Pass values are kept scaled up so that a large ticket count still gives a
+// non-zero stride
+const long long STRIDE_SCALE = 1 << 20;
+
+long long ticketStride(int tickets) {
+    return STRIDE_SCALE / tickets;
+}
+
+// Stride scheduling, the deterministic counterpart of lottery scheduling:
+// the process with the lowest pass runs for a quantum, and its pass grows
+// by its stride for each time unit it ran. New processes start at the
+// global pass (the lowest pass dispatched so far) and waking ones are
+// raised to it, so time spent away earns no credit.
+class StridePolicy : public PolicyDefaults {
+public:
+    static constexpr bool timeSliced = true;
+
+    StridePolicy(ProcessTable& table, const SimTime&, int timeQuantum)
+        : table(table), timeQuantum(timeQuantum), queue(table.size()), pass(table.size(), 0) {}
+
+    bool empty() const { return queue.empty(); }
+    void enqueue(int id) {
+        if (table.currentCpuBurst[id] == 0) {
+            coverProcesses(pass, table, 0LL);
+            pass[id] = globalPass;
+        } else {
+            pass[id] = max(pass[id], globalPass);
+        }
+        insert(id);
+    }
+    int pickNext() {
+        globalPass = max(globalPass, queue.topKey().pass);
+        return queue.pop();
+    }
+    SimTime sliceFor(int id) const { return min(table.remainingCpuBurst[id], timeQuantum); }
+    void charge(int id, SimTime ran) { pass[id] += ran * ticketStride(table.workload.tickets[id]); }
+    // The quantum ran out: back behind every process with the same pass
+    bool expire(int id) {
+        insert(id);
+        return true;
+    }
+    void snapshot(Snapshot& snapshot) {
+        snapshot.io(queue);
+        snapshot.io(pass);
+        snapshot.io(nextOrder);
+        snapshot.io(globalPass);
+    }
+
+private:
+    ProcessTable& table;
+    int timeQuantum;
+    IndexedMinHeap<PassKey> queue;
+    RunVector<long long> pass;
+    long long nextOrder = 0;
+    long long globalPass = 0;
+
+    void insert(int id) { queue.push(id, {pass[id], nextOrder++}); }
+};
+
+void strideScheduling(ProcessTable& table, int timeQuantum, TraceSink& trace, Checkpointer* checkpointer) {
+    simulate<StridePolicy>(table, trace, checkpointer, timeQuantum);
+}
+
+bool isKnownAlgorithm(const string& algorithm) {
+    return algorithm == "FIFO" || algorithm == "SJF" || algorithm == "SRTF" || algorithm == "CFS" || algorithm == "RR" ||
+           algorithm == "MLFQ" || algorithm == "LOTTERY" || algorithm == "STRIDE";
+}
+
+bool usesTimeQuantum(const string& algorithm) {
+    return algorithm == "RR" || algorithm == "LOTTERY" || algorithm == "STRIDE";
+}
+
+bool parseDeviceList(const string& spec, vector<IoDevice>& devices) {
+    devices.clear();
+    stringstream list(spec);
+    string item;
+    while (getline(list, item, ',')) {
+        IoDevice device;
+        size_t colon = item.find(':');
+        string discipline = colon == string::npos ? "fifo" : item.substr(colon + 1);
+        if (discipline == "sstf") {
+            device.discipline = IO_SSTF;
+        } else if (discipline != "fifo") {
+            return false;
+        }
+        try {
+            size_t used;
+            string slots = item.substr(0, colon);
+            device.slots = stoi(slots, &used);
+            if (used != slots.size() || device.slots <= 0) {
+                return false;
+            }
+        } catch (const exception&) {
+            return false;
+        }
+        devices.push_back(device);
+    }
+    return !devices.empty() && devices.size() <= (size_t)MAX_DEVICES;
+}
+
+bool checkDevices(const Workload& workload, const SchedulerOptions& options, string& error) {
+    if (options.devices.empty()) {
+        return true;
+    }
+    for (size_t i = 0; i < workload.numProcesses; i++) {
+        if (workload.device[i] >= options.devices.size()) {
+            error = "P" + to_string(i + 1) + " uses device " + to_string(workload.device[i]) + " but only " +
+                    to_string(options.devices.size()) + " devices are configured";
+            return false;
+        }
+    }
+    return true;
+}
+
+void runScheduler(const string& algorithm, ProcessTable& table, const SchedulerOptions& options, TraceSink& trace,
+                  Checkpointer* checkpointer) {
+    table.devices.assign(options.devices.begin(), options.devices.end());
+    table.deviceStats.assign(options.devices.size(), DeviceStats());
+    if (options.smp.cpus > 1) {
+        smpScheduling(algorithm, table, options, trace, checkpointer);
+    } else if (algorithm == "FIFO") {
+        if (!options.analytic || checkpointer || !analyticFifo(table, trace)) {
+            fifoScheduling(table, trace, checkpointer);
+        }
+    } else if (algorithm == "SJF") {
+        if (!options.analytic || checkpointer || !analyticSjf(table, trace)) {
+            sjfScheduling(table, trace, checkpointer);
+        }
+    } else if (algorithm == "SRTF") {
+        srtfScheduling(table, trace, checkpointer);
+    } else if (algorithm == "CFS") {
+        cfsScheduling(table, options.cfs, trace, checkpointer);
+    } else if (algorithm == "RR") {
+        roundRobinScheduling(table, options.timeQuantum, trace, checkpointer);
+    } else if (algorithm == "MLFQ") {
+        mlfqScheduling(table, options.mlfq, trace, checkpointer);
+    } else if (algorithm == "LOTTERY") {
+        lotteryScheduling(table, options.timeQuantum, options.lotterySeed, trace, checkpointer);
+    } else if (algorithm == "STRIDE") {
+        strideScheduling(table, options.timeQuantum, trace, checkpointer);
+    }
+}
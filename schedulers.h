@@ -0,0 +1,164 @@
+#ifndef SCHEDULERS_H
+#define SCHEDULERS_H
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "simulator.h"
+#include "trace.h"
+
+// Tunables for the CFS simulation, in simulator time units
+struct CfsConfig {
+    int schedLatency = 6;   // Period in which every runnable process should run once
+    int minGranularity = 1; // Shortest slice handed out; also the wakeup-preemption margin
+};
+
+// Tunables for the multi-level feedback queue, in simulator time units
+struct MlfqConfig {
+    int levels = 3;                      // Priority levels, at most 64; 0 is the highest
+    std::vector<int> quanta = {2, 4, 8}; // Quantum per level, top first; the last one repeats
+    int boostInterval = 100;             // Everything returns to the top level this often; 0 never
+
+    int quantumOf(int level) const { return quanta[std::min<size_t>(level, quanta.size() - 1)]; }
+};
+
+// MLFQ level and used quantum of every process. Boosts happen at each
+// multiple of boostInterval and reach a process lazily: one whose level was
+// last settled before the latest boost is back at the top with a fresh
+// quantum. Processes waiting in a run queue are moved up by the queue.
+class MlfqPriorities {
+public:
+    MlfqPriorities(const MlfqConfig& config, int numProcesses)
+        : config(config), levels(numProcesses, 0), used(numProcesses, 0), epochs(numProcesses, 0) {}
+
+    void snapshot(Snapshot& snapshot) {
+        snapshot.io(levels);
+        snapshot.io(used);
+        snapshot.io(epochs);
+    }
+
+    // A new process starts at the top level; also makes room for the IDs a
+    // streaming run adds
+    void admit(int id) {
+        if ((size_t)id >= levels.size()) {
+            levels.resize(id + 1);
+            used.resize(id + 1);
+            epochs.resize(id + 1);
+        }
+        levels[id] = 0;
+        used[id] = 0;
+        epochs[id] = 0;
+    }
+
+    long long boostEpoch(SimTime now) const { return config.boostInterval ? now / config.boostInterval : 0; }
+
+    int levelOf(int id, SimTime now) {
+        long long epoch = boostEpoch(now);
+        if (epochs[id] != epoch) {
+            epochs[id] = epoch;
+            levels[id] = 0;
+            used[id] = 0;
+        }
+        return levels[id];
+    }
+
+    int quantumLeft(int id) const { return config.quantumOf(levels[id]) - used[id]; }
+    bool quantumExpired(int id) const { return quantumLeft(id) <= 0; }
+    void charge(int id, SimTime ran) { used[id] += (int)ran; }
+
+    // Used up its quantum: one level down
+    void demote(int id) {
+        levels[id] = std::min(levels[id] + 1, config.levels - 1);
+        used[id] = 0;
+    }
+
+    // The CPU burst ended: a process that blocked before its quantum ran out
+    // moves one level up, otherwise it is demoted
+    void finishBurst(int id) {
+        if (quantumExpired(id)) {
+            demote(id);
+        } else {
+            levels[id] = std::max(levels[id] - 1, 0);
+            used[id] = 0;
+        }
+    }
+
+private:
+    const MlfqConfig& config;
+    RunVector<int> levels;
+    RunVector<int> used;
+    RunVector<long long> epochs;
+};
+
+// Multiprocessor settings. With one CPU the uniprocessor schedulers below run.
+struct SmpConfig {
+    int cpus = 1;
+    int balanceInterval = 4; // Time between periodic load-balancing passes; 0 disables them
+    int migrationCost = 0;   // Extra CPU time a process needs after moving to another CPU
+};
+
+struct SchedulerOptions {
+    int timeQuantum = 0;      // For RR, LOTTERY and STRIDE
+    uint64_t lotterySeed = 1; // LOTTERY draws the same winners for the same seed
+    bool analytic = true;     // FIFO and SJF skip the event loop where analytic.h applies
+    CfsConfig cfs;
+    MlfqConfig mlfq;
+    SmpConfig smp;
+    std::vector<IoDevice> devices; // Empty: unlimited parallel I/O
+};
+
+// Parse a device list such as "1,4:sstf": one entry per device, device 0
+// first, each a slot count optionally followed by :fifo (default) or :sstf
+bool parseDeviceList(const std::string& spec, std::vector<IoDevice>& devices);
+
+// Every process names one of options.devices, or there are none; otherwise
+// `error` names the first process that does not
+bool checkDevices(const Workload& workload, const SchedulerOptions& options, std::string& error);
+
+// CFS load weight of a nice level (-20 to 19), and a runtime converted to
+// scaled vruntime for a given weight; shared with the multi-CPU engine
+const int NICE_0_WEIGHT = 1024;
+int niceWeight(int nice);
+long long weightedRuntime(long long delta, int weight);
+
+// CFS rules shared with the multi-CPU engine: the slice of a process of
+// `weight` picked with `waiting` others in the queue, the vruntime credit a
+// waking sleeper keeps, and whether a waiting process at `leftmost` should
+// preempt a running one at `vruntime`
+long long cfsSlice(const CfsConfig& config, size_t waiting, int weight, long long runnableWeight);
+long long cfsSleeperCredit(const CfsConfig& config);
+bool cfsWakeupPreempts(const CfsConfig& config, long long leftmost, long long vruntime, int weight);
+
+// Pass a stride-scheduled process gains per time unit run: inversely
+// proportional to its tickets; shared with the multi-CPU engine
+long long ticketStride(int tickets);
+
+// Each scheduler runs the whole workload on one CPU, filling in the
+// completion time of every process in the table and recording each
+// dispatch and idle gap in trace. With a checkpointer the run can be
+// snapshotted, stopped on SIGINT and resumed from a snapshot.
+void fifoScheduling(ProcessTable& table, TraceSink& trace, Checkpointer* checkpointer = nullptr);
+void sjfScheduling(ProcessTable& table, TraceSink& trace, Checkpointer* checkpointer = nullptr);
+void srtfScheduling(ProcessTable& table, TraceSink& trace, Checkpointer* checkpointer = nullptr);
+void cfsScheduling(ProcessTable& table, const CfsConfig& config, TraceSink& trace, Checkpointer* checkpointer = nullptr);
+void roundRobinScheduling(ProcessTable& table, int timeQuantum, TraceSink& trace, Checkpointer* checkpointer = nullptr);
+void mlfqScheduling(ProcessTable& table, const MlfqConfig& config, TraceSink& trace, Checkpointer* checkpointer = nullptr);
+void lotteryScheduling(ProcessTable& table, int timeQuantum, uint64_t seed, TraceSink& trace,
+                       Checkpointer* checkpointer = nullptr);
+void strideScheduling(ProcessTable& table, int timeQuantum, TraceSink& trace, Checkpointer* checkpointer = nullptr);
+
+// FIFO, SJF, SRTF, CFS, RR, MLFQ, LOTTERY or STRIDE
+bool isKnownAlgorithm(const std::string& algorithm);
+// RR, LOTTERY and STRIDE need options.timeQuantum
+bool usesTimeQuantum(const std::string& algorithm);
+
+// Run one of the schedulers above by name, on options.smp.cpus CPUs with
+// I/O going through options.devices, whose stats are left in
+// table.deviceStats. Single-CPU FIFO and SJF runs without a checkpointer
+// are computed analytically when options.analytic is set and the workload
+// allows it.
+void runScheduler(const std::string& algorithm, ProcessTable& table, const SchedulerOptions& options, TraceSink& trace,
+                  Checkpointer* checkpointer = nullptr);
+
+#endif
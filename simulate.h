@@ -0,0 +1,137 @@
+#ifndef SIMULATE_H
+#define SIMULATE_H
+
+#include <algorithm>
+#include <utility>
+#include "checkpoint.h"
+#include "profile.h"
+#include "simulator.h"
+#include "trace.h"
+
+// No-op defaults, so a policy only writes what it uses
+struct PolicyDefaults {
+    static constexpr bool preemptive = false;
+    static constexpr bool timeSliced = false;
+
+    void beginStep() {}
+    void charge(int, SimTime) {}
+    void retire(int) {}
+    bool shouldPreempt(int) const { return false; }
+    void requeue(int) {}
+    bool expire(int) { return false; }
+};
+
+// The uniprocessor scheduling loop, shared by every policy. Each step
+// releases due arrivals and I/O completions to the policy, lets a woken
+// process preempt the running one, picks a process if the CPU is free and
+// runs it for one slice, or jumps the clock to the next event if nothing
+// is ready. Policies are plain classes bound at compile time, so the loop
+// has no virtual calls and the branches a policy does not need are
+// compiled out. A policy provides:
+//
+//   Policy(table, now, args...)  `now` is the simulation clock
+//   preemptive                   constexpr: slices end at the next event,
+//                                where a woken process may take the CPU
+//   timeSliced                   constexpr: slices can end before the burst
+//   empty()                      nothing is waiting
+//   beginStep()                  a new step starts, before events are released
+//   enqueue(id)                  an arriving or woken process becomes ready
+//   pickNext()                   remove and return the process to run
+//   sliceFor(id)                 how long the chosen process may run
+//   charge(id, ran)              it ran `ran` more time units
+//   retire(id)                   its CPU burst ended
+//   shouldPreempt(id), requeue(id)
+//                                preemptive only: a waiting process should
+//                                take over; the running one goes back
+//   expire(id)                   timeSliced only: called when a slice ends
+//                                with the burst unfinished; true if the
+//                                process went back to the queue
+//   snapshot(snapshot)           save or restore the policy's state
+//
+// Arriving processes have table.currentCpuBurst[id] == 0; in streaming runs
+// their IDs may be new or reused, so per-process state is set up there.
+template <typename Policy, typename... Args>
+void simulate(ProcessTable& table, TraceSink& trace, Checkpointer* checkpointer, Args&&... args) {
+    // Slices of run-to-completion policies are whole bursts
+    constexpr bool reportLength = Policy::preemptive || Policy::timeSliced;
+
+    SimTime currentTime = 0;
+    Policy policy(table, currentTime, std::forward<Args>(args)...);
+    EventQueue events(table);
+    int numProcesses = table.processesToComplete();
+    int processesCompleted = 0;
+    int running = -1;
+
+    // Everything the loop carries from one step to the next, for checkpoints
+    auto state = [&](Snapshot& snapshot) {
+        snapshot.io(currentTime);
+        snapshot.io(processesCompleted);
+        snapshot.io(running);
+        snapshot.io(policy);
+        snapshot.io(events);
+        snapshot.io(table);
+    };
+
+    while (processesCompleted < numProcesses) {
+        if (checkpointer && !checkpointer->step(table.events, state)) {
+            return;
+        }
+
+        const RunVector<int>& released = events.releaseDue(currentTime, table);
+        bool picked = false; // Otherwise the running process keeps the CPU for another slice
+        {
+            PROFILE_SCOPE(PHASE_SELECT);
+            policy.beginStep();
+            for (int id : released) {
+                policy.enqueue(id);
+            }
+
+            if constexpr (Policy::preemptive) {
+                if (running != -1 && policy.shouldPreempt(running)) {
+                    policy.requeue(running);
+                    running = -1;
+                }
+            }
+
+            if (running == -1 && !policy.empty()) {
+                running = policy.pickNext();
+                picked = true;
+            }
+        }
+        if (running == -1) {
+            if (!advanceToNextEvent(currentTime, events, trace)) {
+                break;
+            }
+            continue;
+        }
+
+        PROFILE_SCOPE(PHASE_ACCOUNT);
+        // Nothing can preempt the running process before the next event, so a
+        // preemptive policy runs it straight up to that point
+        int32_t& remaining = table.remainingCpuBurst[running];
+        SimTime slice = policy.sliceFor(running);
+        if constexpr (Policy::preemptive) {
+            slice = std::min(slice, events.nextEventTime() - currentTime);
+        }
+
+        if (picked) {
+            table.noteDispatch(running, currentTime);
+        }
+        trace.dispatch(currentTime, running, table.currentCpuBurst[running], slice, reportLength);
+        currentTime += slice;
+        remaining -= (int32_t)slice;
+        policy.charge(running, slice);
+
+        if (remaining == 0) {
+            policy.retire(running);
+            finishCpuBurst(table, running, currentTime, events, processesCompleted);
+            running = -1;
+        } else if constexpr (Policy::timeSliced) {
+            if (policy.expire(running)) {
+                running = -1;
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,262 @@
+#include "simulator.h"
+#include "profile.h"
+#include "trace.h"
+
+#include <algorithm>
+using namespace std;
+
+ProcessTable::ProcessTable(const Workload& workload)
+    : workload(workload),
+      state(workload.numProcesses, NOT_ARRIVED),
+      currentCpuBurst(workload.numProcesses, 0),
+      remainingCpuBurst(workload.numProcesses),
+      ioCompletionTime(workload.numProcesses, 0),
+      nextBurst(workload.numProcesses),
+      completionTime(workload.numProcesses, 0),
+      firstRunTime(workload.numProcesses, -1),
+      readyTime(workload.numProcesses),
+      burstLength(workload.numProcesses) {
+    for (size_t i = 0; i < workload.numProcesses; i++) {
+        load((int)i, workload.burstStream + workload.burstOffset[i]);
+    }
+    metrics.lastOnCpu.assign(1, -1);
+}
+
+ProcessTable::ProcessTable(WorkloadStream& stream) : workload(stream.workload()), stream(&stream) {
+    metrics.lastOnCpu.assign(1, -1);
+}
+
+int ProcessTable::admitNext() {
+    int id = stream->admit();
+    if (id >= size()) {
+        int slots = id + 1;
+        state.resize(slots);
+        currentCpuBurst.resize(slots);
+        remainingCpuBurst.resize(slots);
+        ioCompletionTime.resize(slots);
+        nextBurst.resize(slots);
+        completionTime.resize(slots);
+        firstRunTime.resize(slots);
+        readyTime.resize(slots);
+        burstLength.resize(slots);
+    }
+    state[id] = NOT_ARRIVED;
+    currentCpuBurst[id] = 0;
+    ioCompletionTime[id] = 0;
+    completionTime[id] = 0;
+    firstRunTime[id] = -1;
+    load(id, stream->burstsOf(id));
+    return id;
+}
+
+void ProcessTable::load(int processID, const uint8_t* bursts) {
+    remainingCpuBurst[processID] = readVarint(bursts);
+    nextBurst[processID] = bursts;
+    readyTime[processID] = workload.arrivalTime[processID];
+    burstLength[processID] = remainingCpuBurst[processID];
+}
+
+void ProcessTable::snapshot(Snapshot& snapshot) {
+    // Burst cursors are saved as offsets into the burst stream
+    vector<uint64_t> burstOffsets(nextBurst.size());
+    for (size_t i = 0; i < nextBurst.size(); i++) {
+        burstOffsets[i] = nextBurst[i] - workload.burstStream;
+    }
+
+    snapshot.io(state);
+    snapshot.io(currentCpuBurst);
+    snapshot.io(remainingCpuBurst);
+    snapshot.io(ioCompletionTime);
+    snapshot.io(burstOffsets);
+    snapshot.io(completionTime);
+    snapshot.io(firstRunTime);
+    snapshot.io(readyTime);
+    snapshot.io(burstLength);
+    snapshot.io(dispatches);
+    snapshot.io(events);
+    snapshot.io(cpuStats);
+    snapshot.io(metrics);
+    snapshot.io(deviceStats);
+    if (!snapshot.loading()) {
+        return;
+    }
+
+    size_t n = workload.numProcesses;
+    if (state.size() != n || currentCpuBurst.size() != n || remainingCpuBurst.size() != n || ioCompletionTime.size() != n ||
+        burstOffsets.size() != n || completionTime.size() != n || firstRunTime.size() != n || readyTime.size() != n ||
+        burstLength.size() != n || metrics.lastOnCpu.size() != max<size_t>(cpuStats.size(), 1) ||
+        deviceStats.size() != devices.size()) {
+        snapshot.fail();
+        return;
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (burstOffsets[i] > workload.burstStreamSize) {
+            snapshot.fail();
+            return;
+        }
+        nextBurst[i] = workload.burstStream + burstOffsets[i];
+    }
+}
+
+EventQueue::EventQueue(const ProcessTable& table)
+    : stream(table.stream), arrivalTime(table.workload.arrivalTime), numProcesses(table.workload.numProcesses),
+      devices(table.devices), ioQueues(table.devices.size()) {
+    if (!stream && !is_sorted(arrivalTime, arrivalTime + numProcesses)) {
+        arrivalOrder.resize(numProcesses);
+        for (size_t i = 0; i < numProcesses; i++) {
+            arrivalOrder[i] = (int)i;
+        }
+        // Ties by ID, as a stable sort would leave them, but sorted in place
+        sort(arrivalOrder.begin(), arrivalOrder.end(), [&](int a, int b) {
+            return arrivalTime[a] != arrivalTime[b] ? arrivalTime[a] < arrivalTime[b] : a < b;
+        });
+    }
+}
+
+const RunVector<int>& EventQueue::releaseDue(SimTime currentTime, ProcessTable& table) {
+    PROFILE_SCOPE(PHASE_EVENTS);
+    released.clear();
+    ioCompleted.clear();
+    while (!ioHeap.empty() && ioHeap.top().first <= currentTime) {
+        auto [time, id] = ioHeap.top();
+        ioHeap.pop();
+        ioCompleted.push_back(id);
+        if (!devices.empty()) {
+            serveNext(table, ioQueues[table.workload.device[id]], time);
+        }
+    }
+    if (stream) {
+        // Admitted in input order already; slots say nothing about order, so
+        // I/O completions are ordered by input position as in batch runs
+        while (stream->hasNext() && stream->nextArrival() <= currentTime) {
+            released.push_back(table.admitNext());
+        }
+        const vector<int>& processNumbers = stream->processNumbers();
+        sort(ioCompleted.begin(), ioCompleted.end(), [&](int a, int b) {
+            return processNumbers[a] < processNumbers[b];
+        });
+    } else {
+        while (nextArrival < numProcesses && arrivalTime[arrivalAt(nextArrival)] <= currentTime) {
+            released.push_back(arrivalAt(nextArrival++));
+        }
+        sort(released.begin(), released.end());
+        sort(ioCompleted.begin(), ioCompleted.end());
+    }
+    released.insert(released.end(), ioCompleted.begin(), ioCompleted.end());
+
+    for (int id : released) {
+        table.state[id] = READY;
+    }
+    table.events += released.size();
+    return released;
+}
+
+void EventQueue::requestIo(ProcessTable& table, int processID, SimTime now, int length) {
+    IoRequest request = {0, ioRequests++, now, length, processID};
+    if (devices.empty()) {
+        startIo(table, request, now);
+        return;
+    }
+    int device = table.workload.device[processID];
+    IoQueue& queue = ioQueues[device];
+    if (queue.busySlots < devices[device].slots) {
+        queue.busySlots++;
+        startIo(table, request, now);
+    } else {
+        if (devices[device].discipline == IO_SSTF) {
+            request.priority = length;
+        }
+        queue.waiting.push(request);
+    }
+}
+
+void EventQueue::serveNext(ProcessTable& table, IoQueue& queue, SimTime freedAt) {
+    if (queue.waiting.empty()) {
+        queue.busySlots--;
+        return;
+    }
+    // Requests issued after freedAt (since the last step, while the
+    // completion was still pending) were not there to compete for the slot.
+    // Set them aside; if nothing older waits, the slot sat free until the
+    // first of them was issued. Only the few issued within one step can be
+    // set aside, and under FIFO the first request is always the oldest.
+    deferredIo.clear();
+    while (!queue.waiting.empty() && queue.waiting.top().issued > freedAt) {
+        deferredIo.push_back(queue.waiting.top());
+        queue.waiting.pop();
+    }
+    IoRequest next;
+    if (!queue.waiting.empty()) {
+        next = queue.waiting.top();
+        queue.waiting.pop();
+    } else {
+        auto first = min_element(deferredIo.begin(), deferredIo.end(),
+                                 [](const IoRequest& a, const IoRequest& b) { return a.sequence < b.sequence; });
+        next = *first;
+        deferredIo.erase(first);
+    }
+    for (const IoRequest& request : deferredIo) {
+        queue.waiting.push(request);
+    }
+    startIo(table, next, max(freedAt, next.issued));
+}
+
+void EventQueue::startIo(ProcessTable& table, const IoRequest& request, SimTime now) {
+    int id = request.processID;
+    table.ioCompletionTime[id] = now + request.length;
+    table.readyTime[id] = table.ioCompletionTime[id];
+    ioHeap.push({table.ioCompletionTime[id], id});
+    if (!devices.empty()) {
+        DeviceStats& stats = table.deviceStats[table.workload.device[id]];
+        stats.busyTime += request.length;
+        stats.queueing.add(now - request.issued);
+    }
+}
+
+void finishCpuBurst(ProcessTable& table, int processID, SimTime currentTime, EventQueue& events, int& processesCompleted) {
+    const Workload& workload = table.workload;
+    RunMetrics& metrics = table.metrics;
+    metrics.burstWaiting.add(currentTime - table.readyTime[processID] - table.burstLength[processID]);
+
+    int burst = ++table.currentCpuBurst[processID];
+    if (burst < workload.numCpuBursts[processID]) {
+        const uint8_t*& cursor = table.nextBurst[processID];
+        table.state[processID] = IN_IO;
+        int ioLength = readVarint(cursor);
+        table.remainingCpuBurst[processID] = readVarint(cursor);
+        table.burstLength[processID] = table.remainingCpuBurst[processID];
+        events.requestIo(table, processID, currentTime, ioLength);
+    } else {
+        table.state[processID] = COMPLETED;
+        table.completionTime[processID] = currentTime;
+        processesCompleted++;
+
+        SimTime turnaroundTime = currentTime - workload.arrivalTime[processID];
+        metrics.turnaround.add(turnaroundTime);
+        metrics.waiting.add(turnaroundTime - workload.totalCpuBurstTime[processID]);
+        metrics.cpuTime += workload.totalCpuBurstTime[processID];
+        metrics.makespan = max<SimTime>(metrics.makespan, currentTime);
+        if (table.stream) {
+            table.stream->retire(processID);
+        }
+    }
+}
+
+bool advanceToNextEvent(SimTime& currentTime, const EventQueue& events, TraceSink& trace) {
+    PROFILE_SCOPE(PHASE_EVENTS);
+    SimTime nextEventTime = events.nextEventTime();
+    if (nextEventTime == NO_EVENT) {
+        return false;
+    }
+    currentTime = nextEventTime;
+    trace.idle(currentTime);
+    return true;
+}
+
+RunSummary summarizeRun(const ProcessTable& table) {
+    RunSummary summary;
+    summary.averageTurnaroundTime = table.metrics.turnaround.mean();
+    summary.averageWaitingTime = table.metrics.waiting.mean();
+    summary.makespan = table.metrics.makespan;
+    return summary;
+}
@@ -0,0 +1,250 @@
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include <climits>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+#include "arena.h"
+#include "checkpoint.h"
+#include "metrics.h"
+#include "workload.h"
+
+class TraceSink;
+
+// Simulated time. 64-bit so that long traces cannot overflow the clock.
+typedef long long SimTime;
+const SimTime NO_EVENT = LLONG_MAX;
+
+enum ProcessState : uint8_t {
+    NOT_ARRIVED,
+    READY,     // In the ready queue or running
+    IN_IO,
+    COMPLETED,
+};
+
+// What one CPU did over a multi-CPU run
+struct CpuStats {
+    SimTime busyTime = 0;
+    long long dispatches = 0;
+    long long migrations = 0; // Processes that moved here from the CPU they last ran on
+};
+
+// Order in which an I/O device serves the requests waiting for it
+enum IoDiscipline : uint8_t {
+    IO_FIFO, // Oldest request first
+    IO_SSTF, // Shortest service time first: shortest I/O burst, then oldest
+};
+
+// An I/O device serving at most `slots` requests at once; the rest queue
+struct IoDevice {
+    int slots = 1;
+    IoDiscipline discipline = IO_FIFO;
+};
+
+// What one I/O device did over a run with devices
+struct DeviceStats {
+    SimTime busyTime = 0;         // Service time of every request, summed over the slots
+    StreamingHistogram queueing;  // Request to start of service, per request
+
+    void snapshot(Snapshot& snapshot) {
+        snapshot.io(busyTime);
+        snapshot.io(queueing);
+    }
+};
+
+// Mutable per-run state of every process, as parallel arrays indexed by
+// process ID. The hot arrays are what the scheduling loops touch on each
+// dispatch; results are kept apart so they do not dilute the cache. The
+// immutable per-process data (arrival, bursts, nice, tickets) stays in the
+// Workload.
+//
+// In streaming mode the IDs are slots of a WorkloadStream instead: the
+// table starts empty, grows as processes are admitted and hands a slot
+// back once its process completes, so per-process results are not kept
+// and only the run-wide metrics survive the run.
+struct ProcessTable {
+    const Workload& workload;
+    WorkloadStream* stream = nullptr; // Set in streaming mode
+
+    // Hot
+    RunVector<uint8_t> state;
+    RunVector<int32_t> currentCpuBurst;
+    RunVector<int32_t> remainingCpuBurst; // Time left in the current CPU burst
+    RunVector<SimTime> ioCompletionTime;
+    RunVector<const uint8_t*> nextBurst;    // Cursor into the workload's burst stream
+
+    // Cold
+    RunVector<SimTime> completionTime;
+    RunVector<SimTime> firstRunTime; // First dispatch, -1 until then
+    RunVector<SimTime> readyTime;      // When the current CPU burst became ready
+    RunVector<int32_t> burstLength;  // Length of the current CPU burst
+
+    // Run-wide counters
+    long long dispatches = 0; // Times a process was put on the CPU
+    long long events = 0;     // Arrivals and I/O completions handled
+    RunVector<CpuStats> cpuStats; // Filled in by multi-CPU runs only
+    RunMetrics metrics;
+
+    // I/O devices that processes queue for, by the device each names, and
+    // what each did. With none, every I/O burst starts as soon as it is
+    // issued, however many are in progress.
+    RunVector<IoDevice> devices;
+    RunVector<DeviceStats> deviceStats;
+
+    // Fresh state for a run, with the first CPU burst of every process loaded
+    explicit ProcessTable(const Workload& workload);
+    // Empty table for a streaming run over `stream`
+    explicit ProcessTable(WorkloadStream& stream);
+
+    int size() const { return (int)state.size(); }
+
+    // Completed processes after which a run is over; unknown in streaming
+    // mode, where runs end once no events are left
+    int processesToComplete() const { return stream ? INT_MAX : size(); }
+
+    // Streaming mode: take the next process from the stream, load its first
+    // CPU burst and return its ID
+    int admitNext();
+
+    // Everything but the workload, which a resumed run loads itself
+    void snapshot(Snapshot& snapshot);
+
+    // Input-order index of a process, which outlives its ID in streaming mode
+    int processNumber(int processID) const { return stream ? stream->processNumbers()[processID] : processID; }
+
+    // processID is put on `cpu` at `start`; metrics.lastOnCpu must cover `cpu`
+    void noteDispatch(int processID, SimTime start, int cpu = 0) {
+        dispatches++;
+        int process = processNumber(processID); // Slots are reused
+        int& last = metrics.lastOnCpu[cpu];
+        if (last != process) {
+            metrics.contextSwitches += last != -1;
+            last = process;
+        }
+        if (firstRunTime[processID] < 0) {
+            firstRunTime[processID] = start;
+            metrics.response.add(start - workload.arrivalTime[processID]);
+        }
+    }
+
+private:
+    void load(int processID, const uint8_t* bursts);
+};
+
+// Grow a scheduler's per-process array to cover every ID in the table,
+// which gains IDs as a streaming run admits processes
+template <typename T, typename Allocator>
+void coverProcesses(std::vector<T, Allocator>& perProcess, const ProcessTable& table, const T& initial) {
+    if (perProcess.size() < (size_t)table.size()) {
+        perProcess.resize(table.size(), initial);
+    }
+}
+
+// Future arrival and I/O-completion events. Arrivals are walked in arrival
+// order straight from the workload; only pending I/O completions sit in a
+// min-heap, so memory tracks the number of processes in I/O. With devices,
+// a request finding every slot of its device busy waits in that device's
+// queue and is started, and its completion scheduled, when a slot frees up.
+class EventQueue {
+public:
+    explicit EventQueue(const ProcessTable& table);
+
+    // processID issues an I/O burst of `length` at `now`: start it, or queue
+    // it if its device is busy. Sets its I/O completion and ready times once
+    // it starts.
+    void requestIo(ProcessTable& table, int processID, SimTime now, int length);
+
+    // Time of the earliest pending event, or NO_EVENT if there is none
+    SimTime nextEventTime() const {
+        SimTime next = ioHeap.empty() ? NO_EVENT : ioHeap.top().first;
+        if (stream) {
+            if (stream->hasNext()) {
+                next = std::min<SimTime>(next, stream->nextArrival());
+            }
+        } else if (nextArrival < numProcesses) {
+            next = std::min<SimTime>(next, arrivalTime[arrivalAt(nextArrival)]);
+        }
+        return next;
+    }
+
+    // Pop every event due at or before currentTime, mark the processes
+    // READY and return them in ready-queue order: new arrivals by index, then
+    // I/O completions by index. Streaming runs admit the arrivals here.
+    const RunVector<int>& releaseDue(SimTime currentTime, ProcessTable& table);
+
+    void snapshot(Snapshot& snapshot) {
+        snapshot.io(nextArrival);
+        snapshot.io(ioHeap);
+        snapshot.io(ioQueues);
+        snapshot.io(ioRequests);
+        if (snapshot.loading() && ioQueues.size() != devices.size()) {
+            snapshot.fail();
+        }
+    }
+
+private:
+    // A request waiting for a device, ordered by (priority, sequence)
+    struct IoRequest {
+        SimTime priority;   // The burst length under SSTF, 0 under FIFO
+        long long sequence; // Requests issued before this one
+        SimTime issued;
+        int32_t length;
+        int32_t processID;
+
+        bool operator>(const IoRequest& other) const {
+            return priority != other.priority ? priority > other.priority : sequence > other.sequence;
+        }
+    };
+
+    struct IoQueue {
+        int busySlots = 0;
+        std::priority_queue<IoRequest, RunVector<IoRequest>, std::greater<IoRequest>> waiting;
+
+        void snapshot(Snapshot& snapshot) {
+            snapshot.io(busySlots);
+            snapshot.io(waiting);
+        }
+    };
+
+    WorkloadStream* stream;
+    const int32_t* arrivalTime;
+    size_t numProcesses;
+    RunVector<int> arrivalOrder; // Process IDs by arrival time; empty if the workload is already sorted
+    size_t nextArrival = 0;
+    std::priority_queue<std::pair<SimTime, int>, RunVector<std::pair<SimTime, int>>, std::greater<std::pair<SimTime, int>>> ioHeap;
+    RunVector<int> released;
+    RunVector<int> ioCompleted;
+    const RunVector<IoDevice>& devices;
+    RunVector<IoQueue> ioQueues; // One per device
+    long long ioRequests = 0;
+    RunVector<IoRequest> deferredIo;
+
+    // A slot of the queue's device came free at freedAt: start the request
+    // it goes to, if any
+    void serveNext(ProcessTable& table, IoQueue& queue, SimTime freedAt);
+    void startIo(ProcessTable& table, const IoRequest& request, SimTime now);
+
+    int arrivalAt(size_t position) const {
+        return arrivalOrder.empty() ? (int)position : arrivalOrder[position];
+    }
+};
+
+// The current CPU burst of a process has run to the end: send it to I/O or mark it completed
+void finishCpuBurst(ProcessTable& table, int processID, SimTime currentTime, EventQueue& events, int& processesCompleted);
+
+// Jump to the next arrival or I/O completion; returns false if nothing is pending
+bool advanceToNextEvent(SimTime& currentTime, const EventQueue& events, TraceSink& trace);
+
+struct RunSummary {
+    double averageTurnaroundTime = 0;
+    double averageWaitingTime = 0;
+    SimTime makespan = 0; // Completion time of the last process
+};
+
+// Averages from the metrics gathered during the run; zero for an empty workload
+RunSummary summarizeRun(const ProcessTable& table);
+
+#endif
@@ -0,0 +1,772 @@
+#include "smp.h"
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <queue>
+#include <set>
+#include <tuple>
+#include <vector>
+#include "profile.h"
+#include "ready_queue.h"
+#include "trace.h"
+using namespace std;
+
+// State shared by the run queues of every CPU
+struct SmpShared {
+    SmpShared(ProcessTable& table, const SchedulerOptions& options) : table(table), options(options) {}
+
+    ProcessTable& table;
+    const SchedulerOptions& options;
+    SimTime now = 0;               // Time of the step being simulated
+    RunVector<long long> vruntime; // CFS only
+    RunVector<int> mlfqLinks;      // MLFQ only: the intrusive lists of every CPU's queue
+    MlfqPriorities* mlfq = nullptr;
+    RunVector<long long> pass;     // STRIDE only
+    uint64_t randomState = 0;      // LOTTERY only: one sequence of draws for every CPU
+
+    void snapshot(Snapshot& snapshot) {
+        snapshot.io(now);
+        snapshot.io(vruntime);
+        snapshot.io(mlfqLinks);
+        snapshot.io(pass);
+        snapshot.io(randomState);
+        if (mlfq) {
+            snapshot.io(*mlfq);
+        }
+    }
+};
+
+// Per-CPU run queues. A process waits in at most one CPU's queue, and the
+// process a CPU is running is kept out of its queue.
+//
+// These are not the simulate.h policies run once per CPU. A policy owns
+// per-process state sized to the whole table (vruntime, pass, MLFQ links),
+// which every CPU would then hold a copy of; here it lives once in
+// SmpShared. A policy also cannot hand a waiting process to another CPU,
+// rebasing its vruntime or pass on the way, and it decides for itself
+// whether an expired slice is renewed, which the SMP loop does instead.
+// What both need to agree on is shared rather than copied: the CFS rules
+// and weights, ticketStride, TicketTree, LevelQueue and MlfqPriorities.
+// Each queue provides:
+//   enqueue(id, migrated)  an arriving or woken process joins the queue
+//   requeue(id)            the running process goes back after a preemption
+//   pickNext()             remove and return the process to run next
+//   detach() / attach(id)  move a waiting process to another CPU's queue
+//   retire(id)             the running process left for I/O or completed
+//   charge(id, ran)        the running process used `ran` more time units
+//   sliceFor(id)           how much longer the running process may run
+//   renewSlice(id)         its slice ran out but nobody else is waiting
+//   shouldPreempt(id)      a waiting process should take over the CPU now
+//   snapshot(snapshot)     save or restore the queue for a checkpoint
+
+// FIFO, or RR when given a time quantum
+class FifoRunQueue {
+public:
+    FifoRunQueue(SmpShared& shared, int timeQuantum) : shared(&shared), timeQuantum(timeQuantum) {}
+
+    bool empty() const { return queue.empty(); }
+    size_t size() const { return queue.size(); }
+
+    void enqueue(int id, bool) { queue.push_back(id); }
+    void requeue(int id) { queue.push_back(id); }
+    int pickNext() {
+        int id = queue.front();
+        queue.pop_front();
+        sliceLeft = timeQuantum;
+        return id;
+    }
+    int detach() {
+        int id = queue.front();
+        queue.pop_front();
+        return id;
+    }
+    void attach(int id) { queue.push_back(id); }
+    void retire(int) {}
+    void charge(int, SimTime ran) { sliceLeft -= ran; }
+    SimTime sliceFor(int id) const {
+        SimTime remaining = shared->table.remainingCpuBurst[id];
+        return timeQuantum ? min(sliceLeft, remaining) : remaining;
+    }
+    void renewSlice(int) { sliceLeft = timeQuantum; }
+    bool shouldPreempt(int) const { return false; }
+    void snapshot(Snapshot& snapshot) {
+        snapshot.io(queue);
+        snapshot.io(sliceLeft);
+    }
+
+private:
+    SmpShared* shared;
+    int timeQuantum; // 0 runs every burst to the end
+    RunDeque<int> queue;
+    SimTime sliceLeft = 0;
+};
+
+// SJF, or SRTF when preemptive
+class BurstRunQueue {
+public:
+    BurstRunQueue(SmpShared& shared, bool preemptive) : shared(&shared), preemptive(preemptive) {}
+
+    bool empty() const { return queue.empty(); }
+    size_t size() const { return queue.size(); }
+
+    void enqueue(int id, bool) { queue.push({{remainingOf(id), nextOrder++}, id}); }
+    // A preempted process keeps its place among equal remaining times
+    void requeue(int id) { queue.push({{remainingOf(id), runningOrder}, id}); }
+    int pickNext() {
+        int id = queue.top().second;
+        runningOrder = queue.top().first.order;
+        queue.pop();
+        return id;
+    }
+    int detach() {
+        int id = queue.top().second;
+        queue.pop();
+        return id;
+    }
+    void attach(int id) { enqueue(id, true); }
+    void retire(int) {}
+    void charge(int, SimTime) {}
+    SimTime sliceFor(int id) const { return remainingOf(id); }
+    void renewSlice(int) {}
+    bool shouldPreempt(int id) const {
+        return preemptive && !queue.empty() && queue.top().first < BurstKey{remainingOf(id), runningOrder};
+    }
+    void snapshot(Snapshot& snapshot) {
+        snapshot.io(queue);
+        snapshot.io(nextOrder);
+        snapshot.io(runningOrder);
+    }
+
+private:
+    typedef pair<BurstKey, int> Entry;
+
+    SmpShared* shared;
+    bool preemptive;
+    priority_queue<Entry, RunVector<Entry>, greater<Entry>> queue;
+    long long nextOrder = 0;
+    long long runningOrder = 0;
+
+    int remainingOf(int id) const { return shared->table.remainingCpuBurst[id]; }
+};
+
+// CFS, with one timeline and min_vruntime per CPU as in Linux. A process
+// that changes CPU has its vruntime rebased onto the new CPU's min_vruntime.
+class CfsRunQueue {
+public:
+    explicit CfsRunQueue(SmpShared& shared) : shared(&shared) {}
+
+    bool empty() const { return timeline.empty(); }
+    size_t size() const { return timeline.size(); }
+
+    void enqueue(int id, bool migrated) {
+        const CfsConfig& config = shared->options.cfs;
+        bool arriving = shared->table.currentCpuBurst[id] == 0;
+        if (arriving) {
+            coverProcesses(shared->vruntime, shared->table, 0LL);
+        }
+        long long& vruntime = shared->vruntime[id];
+        long long sleeperCredit = arriving ? 0 : cfsSleeperCredit(config);
+        vruntime = migrated || arriving ? minVruntime - sleeperCredit : max(vruntime, minVruntime - sleeperCredit);
+        runnableWeight += weightOf(id);
+        insert(id);
+    }
+    void requeue(int id) { insert(id); }
+    int pickNext() {
+        int id = get<2>(*timeline.begin());
+        timeline.erase(timeline.begin());
+        sliceLeft = cfsSlice(shared->options.cfs, timeline.size(), weightOf(id), runnableWeight);
+        return id;
+    }
+    int detach() {
+        int id = get<2>(*timeline.begin());
+        timeline.erase(timeline.begin());
+        shared->vruntime[id] -= minVruntime;
+        runnableWeight -= weightOf(id);
+        return id;
+    }
+    void attach(int id) {
+        shared->vruntime[id] += minVruntime;
+        runnableWeight += weightOf(id);
+        insert(id);
+    }
+    void retire(int id) { runnableWeight -= weightOf(id); }
+    void charge(int id, SimTime ran) {
+        long long& vruntime = shared->vruntime[id];
+        vruntime += weightedRuntime(ran, weightOf(id));
+        sliceLeft -= ran;
+        long long leftmost = timeline.empty() ? vruntime : min(vruntime, get<0>(*timeline.begin()));
+        minVruntime = max(minVruntime, leftmost);
+        if (sliceLeft <= 0 && timeline.empty()) {
+            sliceLeft = shared->options.cfs.schedLatency;
+        }
+    }
+    // With nobody else waiting there is nothing to switch to, so the slice
+    // does not bound the run
+    SimTime sliceFor(int id) const {
+        SimTime remaining = shared->table.remainingCpuBurst[id];
+        return timeline.empty() ? remaining : min<SimTime>(sliceLeft, remaining);
+    }
+    void renewSlice(int) { sliceLeft = shared->options.cfs.schedLatency; }
+    // Wakeup preemption: a process sufficiently far behind takes over
+    bool shouldPreempt(int id) const {
+        return !timeline.empty() &&
+               cfsWakeupPreempts(shared->options.cfs, get<0>(*timeline.begin()), shared->vruntime[id], weightOf(id));
+    }
+    void snapshot(Snapshot& snapshot) {
+        snapshot.io(timeline);
+        snapshot.io(nextOrder);
+        snapshot.io(minVruntime);
+        snapshot.io(runnableWeight);
+        snapshot.io(sliceLeft);
+    }
+
+private:
+    SmpShared* shared;
+    RunSet<tuple<long long, long long, int>> timeline;
+    long long nextOrder = 0;
+    long long minVruntime = 0;
+    long long runnableWeight = 0; // Waiting processes plus the running one
+    long long sliceLeft = 0;
+
+    int weightOf(int id) const { return niceWeight(shared->table.workload.nice[id]); }
+    void insert(int id) { timeline.insert({shared->vruntime[id], nextOrder++, id}); }
+};
+
+// MLFQ over a LevelQueue. A process preempted by a higher level goes back to
+// the front of its level; one that used up its quantum is demoted to the back
+// of the next. Each CPU applies priority boosts to its own queue the first
+// time it is touched after one is due.
+class MlfqRunQueue {
+public:
+    explicit MlfqRunQueue(SmpShared& shared) : shared(&shared), queue(shared.options.mlfq.levels, &shared.mlfqLinks) {}
+
+    bool empty() const { return queue.empty(); }
+    size_t size() const { return queue.size(); }
+
+    // attach() comes through here too, so only a process that is not
+    // migrating can be arriving
+    void enqueue(int id, bool migrated) {
+        applyBoost();
+        if (!migrated && shared->table.currentCpuBurst[id] == 0) {
+            coverProcesses(shared->mlfqLinks, shared->table, -1);
+            shared->mlfq->admit(id);
+        }
+        queue.pushBack(id, levelOf(id));
+    }
+    void requeue(int id) {
+        applyBoost();
+        if (shared->mlfq->quantumExpired(id)) {
+            shared->mlfq->demote(id);
+            queue.pushBack(id, levelOf(id));
+        } else {
+            queue.pushFront(id, levelOf(id));
+        }
+    }
+    int pickNext() {
+        applyBoost();
+        int id = queue.pop();
+        levelOf(id);
+        return id;
+    }
+    int detach() {
+        applyBoost();
+        return queue.pop();
+    }
+    void attach(int id) { enqueue(id, true); }
+    void retire(int id) { shared->mlfq->finishBurst(id); }
+    void charge(int id, SimTime ran) { shared->mlfq->charge(id, ran); }
+    SimTime sliceFor(int id) const {
+        return min<SimTime>(shared->mlfq->quantumLeft(id), shared->table.remainingCpuBurst[id]);
+    }
+    void renewSlice(int id) {
+        shared->mlfq->demote(id);
+        levelOf(id);
+    }
+    bool shouldPreempt(int id) {
+        applyBoost();
+        return !queue.empty() && queue.highestLevel() < levelOf(id);
+    }
+    void snapshot(Snapshot& snapshot) {
+        snapshot.io(queue);
+        snapshot.io(queueEpoch);
+    }
+
+private:
+    SmpShared* shared;
+    LevelQueue queue;
+    long long queueEpoch = 0;
+
+    int levelOf(int id) { return shared->mlfq->levelOf(id, shared->now); }
+    void applyBoost() {
+        long long epoch = shared->mlfq->boostEpoch(shared->now);
+        if (epoch != queueEpoch) {
+            queueEpoch = epoch;
+            queue.mergeAll();
+        }
+    }
+};
+
+// Event-driven simulation of several CPUs, each with a Queue. The clock
+// jumps between arrivals, I/O completions and the end of the earliest
+// running slice; at each step slices that ended are settled first, then
+// due events are placed on CPUs, then queues are balanced, and finally
+// every CPU touched by any of this picks what to run.
+template <typename Queue>
+class SmpSimulation {
+public:
+    SmpSimulation(ProcessTable& table, const SmpConfig& config, const Queue& prototype, SmpShared& shared, TraceSink& trace,
+                  Checkpointer* checkpointer)
+        : table(table), config(config), shared(shared), clock(shared.now), trace(trace), checkpointer(checkpointer), events(table),
+          cpus(config.cpus, Cpu{prototype}), lastCpu(table.size(), -1), sliceEnds(config.cpus),
+          queued(config.cpus, 0), loads(config.cpus, 0), idlePosition(config.cpus) {
+        table.cpuStats.assign(config.cpus, CpuStats());
+        table.metrics.lastOnCpu.assign(config.cpus, -1);
+        for (int c = config.cpus - 1; c >= 0; c--) {
+            idlePosition[c] = (int)idleCpus.size();
+            idleCpus.push_back(c);
+        }
+    }
+
+    void run() {
+        int numProcesses = table.processesToComplete();
+        clock = 0;
+
+        // Everything carried from one step to the next, for checkpoints
+        auto state = [&](Snapshot& snapshot) {
+            snapshot.io(shared);
+            snapshot.io(cpus);
+            snapshot.io(lastCpu);
+            snapshot.io(sliceEnds);
+            snapshot.io(queued);
+            snapshot.io(loads);
+            snapshot.io(idleCpus);
+            snapshot.io(idlePosition);
+            snapshot.io(busyCpus);
+            snapshot.io(waiting);
+            snapshot.io(nextBalance);
+            snapshot.io(processesCompleted);
+            snapshot.io(events);
+            snapshot.io(table);
+        };
+
+        while (processesCompleted < numProcesses) {
+            if (checkpointer && !checkpointer->step(table.events, state)) {
+                return;
+            }
+
+            SimTime now;
+            {
+                PROFILE_SCOPE(PHASE_EVENTS);
+                now = min(events.nextEventTime(), nextSliceEnd());
+                if (now == NO_EVENT) {
+                    break;
+                }
+                if (busyCpus == 0 && now > clock) {
+                    trace.idle(now);
+                }
+                clock = now;
+            }
+
+            {
+                PROFILE_SCOPE(PHASE_ACCOUNT);
+                expireSlices(now);
+            }
+            const RunVector<int>& released = events.releaseDue(now, table);
+            PROFILE_SCOPE(PHASE_SELECT);
+            for (int id : released) {
+                place(id, now);
+            }
+            if (config.balanceInterval > 0 && now >= nextBalance) {
+                balance();
+                nextBalance = now + config.balanceInterval;
+            }
+            reschedule(now);
+        }
+    }
+
+private:
+    struct Cpu {
+        Queue queue;
+        int running = -1;
+        SimTime chargedUntil = 0; // The running process has been charged up to here
+        bool marked = false;
+        SimTime recordStart = 0;  // Open trace record for the running process
+        long long recordSlices = 0;
+
+        void snapshot(Snapshot& snapshot) {
+            snapshot.io(queue);
+            snapshot.io(running);
+            snapshot.io(chargedUntil);
+            snapshot.io(recordStart);
+            snapshot.io(recordSlices);
+        }
+    };
+
+    ProcessTable& table;
+    const SmpConfig& config;
+    SmpShared& shared;
+    SimTime& clock; // Shared with the run queues
+    TraceSink& trace;
+    Checkpointer* checkpointer;
+    EventQueue events;
+    RunVector<Cpu> cpus;
+    RunVector<int> lastCpu; // CPU each process last ran on, -1 before its first dispatch
+    IndexedMinHeap<pair<SimTime, int>> sliceEnds; // End of each running CPU's slice, ties by CPU
+    RunVector<int> queued;       // Length of each CPU's queue
+    RunVector<int> loads;        // Queue length plus the running process, kept contiguous for scans
+    RunVector<int> idleCpus;     // Not running anything and nothing queued
+    RunVector<int> idlePosition; // Slot in idleCpus, -1 if busy
+    RunVector<int> markedCpus;   // Need a scheduling decision this step
+    int busyCpus = 0;
+    size_t waiting = 0;          // Processes in any queue
+    SimTime nextBalance = 0;
+    int processesCompleted = 0;
+
+    SimTime nextSliceEnd() const {
+        return sliceEnds.empty() ? NO_EVENT : sliceEnds.topKey().first;
+    }
+
+    void updateIdle(int c) {
+        bool idle = cpus[c].running == -1 && cpus[c].queue.empty();
+        if (idle && idlePosition[c] == -1) {
+            idlePosition[c] = (int)idleCpus.size();
+            idleCpus.push_back(c);
+        } else if (!idle && idlePosition[c] != -1) {
+            int last = idleCpus.back();
+            idleCpus[idlePosition[c]] = last;
+            idlePosition[last] = idlePosition[c];
+            idleCpus.pop_back();
+            idlePosition[c] = -1;
+        }
+    }
+
+    void mark(int c) {
+        if (!cpus[c].marked) {
+            cpus[c].marked = true;
+            markedCpus.push_back(c);
+        }
+        updateIdle(c);
+    }
+
+    // Bring the running process's accounting up to now
+    void charge(int c, SimTime now) {
+        Cpu& cpu = cpus[c];
+        SimTime ran = now - cpu.chargedUntil;
+        if (cpu.running == -1 || ran == 0) {
+            return;
+        }
+        table.remainingCpuBurst[cpu.running] -= (int32_t)ran;
+        cpu.queue.charge(cpu.running, ran);
+        table.cpuStats[c].busyTime += ran;
+        cpu.chargedUntil = now;
+    }
+
+    void startSlice(int c, SimTime now) {
+        if (sliceEnds.contains(c)) {
+            sliceEnds.erase(c);
+        }
+        sliceEnds.push(c, {now + cpus[c].queue.sliceFor(cpus[c].running), c});
+    }
+
+    void dispatch(int c, SimTime now) {
+        Cpu& cpu = cpus[c];
+        cpu.running = cpu.queue.pickNext();
+        queued[c]--;
+        waiting--;
+        busyCpus++;
+        lastCpu[cpu.running] = c;
+        cpu.chargedUntil = now;
+        cpu.recordStart = now;
+        cpu.recordSlices = 1;
+        table.noteDispatch(cpu.running, now, c);
+        table.cpuStats[c].dispatches++;
+        startSlice(c, now);
+    }
+
+    // The running process leaves the CPU; the caller decides where it goes
+    int release(int c, SimTime now) {
+        Cpu& cpu = cpus[c];
+        int id = cpu.running;
+        trace.cpuDispatch(c, cpu.recordStart, id, table.currentCpuBurst[id], now - cpu.recordStart, cpu.recordSlices);
+        cpu.running = -1;
+        sliceEnds.erase(c);
+        loads[c]--;
+        busyCpus--;
+        mark(c);
+        return id;
+    }
+
+    void preempt(int c, SimTime now) {
+        Cpu& cpu = cpus[c];
+        int id = release(c, now);
+        cpu.queue.requeue(id);
+        queued[c]++;
+        loads[c]++;
+        waiting++;
+        updateIdle(c);
+    }
+
+    void expireSlices(SimTime now) {
+        while (nextSliceEnd() <= now) {
+            int c = sliceEnds.top();
+            Cpu& cpu = cpus[c];
+            charge(c, now);
+            int id = cpu.running;
+            if (table.remainingCpuBurst[id] <= 0) {
+                release(c, now);
+                cpu.queue.retire(id);
+                finishCpuBurst(table, id, now, events, processesCompleted);
+            } else if (cpu.queue.empty()) {
+                cpu.queue.renewSlice(id);
+                cpu.recordSlices++;
+                table.dispatches++;
+                table.cpuStats[c].dispatches++;
+                startSlice(c, now);
+            } else {
+                preempt(c, now);
+            }
+        }
+    }
+
+    // Move the next waiting process on `from` over to `to`
+    void migrate(int from, int to) {
+        int id = cpus[from].queue.detach();
+        if (lastCpu[id] != -1 && lastCpu[id] != to) {
+            table.remainingCpuBurst[id] += config.migrationCost;
+            table.cpuStats[to].migrations++;
+        }
+        cpus[to].queue.attach(id);
+        queued[from]--;
+        loads[from]--;
+        queued[to]++;
+        loads[to]++;
+        updateIdle(from);
+        mark(to);
+    }
+
+    void place(int id, SimTime now) {
+        if (table.currentCpuBurst[id] == 0) {
+            coverProcesses(lastCpu, table, -1);
+            lastCpu[id] = -1;
+        }
+        int target = lastCpu[id];
+        if (target == -1) {
+            // New process: an idle CPU, else the least loaded one
+            if (!idleCpus.empty()) {
+                target = idleCpus.back();
+            } else {
+                target = 0;
+                for (int c = 1; c < config.cpus; c++) {
+                    if (loads[c] < loads[target]) {
+                        target = c;
+                    }
+                }
+            }
+        } else if (idlePosition[target] == -1 && !idleCpus.empty()) {
+            // Its last CPU is busy but another is idle
+            target = idleCpus.back();
+        }
+
+        bool migrated = lastCpu[id] != -1 && lastCpu[id] != target;
+        if (migrated) {
+            table.remainingCpuBurst[id] += config.migrationCost;
+            table.cpuStats[target].migrations++;
+        }
+        charge(target, now);
+        cpus[target].queue.enqueue(id, migrated);
+        queued[target]++;
+        loads[target]++;
+        waiting++;
+        mark(target);
+    }
+
+    // Even out queue lengths, one process at a time from the most to the
+    // least loaded CPU
+    void balance() {
+        while (waiting > 0) {
+            int busiest = -1, idlest = 0;
+            for (int c = 0; c < config.cpus; c++) {
+                if (queued[c] > 0 && (busiest == -1 || loads[c] > loads[busiest])) {
+                    busiest = c;
+                }
+                if (loads[c] < loads[idlest]) {
+                    idlest = c;
+                }
+            }
+            if (busiest == -1 || loads[busiest] < loads[idlest] + 2) {
+                return;
+            }
+            migrate(busiest, idlest);
+        }
+    }
+
+    // Idle balancing: pull a process from the longest queue
+    void steal(int c) {
+        int busiest = (int)(max_element(queued.begin(), queued.end()) - queued.begin());
+        if (queued[busiest] > 0) {
+            migrate(busiest, c);
+        }
+    }
+
+    void reschedule(SimTime now) {
+        for (size_t i = 0; i < markedCpus.size(); i++) {
+            int c = markedCpus[i];
+            Cpu& cpu = cpus[c];
+            cpu.marked = false;
+            if (cpu.running != -1) {
+                charge(c, now);
+                if (!cpu.queue.shouldPreempt(cpu.running)) {
+                    // Keep running, but the slice may have changed
+                    startSlice(c, now);
+                    continue;
+                }
+                preempt(c, now);
+            }
+            if (cpu.queue.empty() && waiting > 0) {
+                steal(c);
+            }
+            if (!cpu.queue.empty()) {
+                dispatch(c, now);
+            }
+            updateIdle(c);
+        }
+        for (int c : markedCpus) {
+            cpus[c].marked = false;
+        }
+        markedCpus.clear();
+    }
+};
+
+// Lottery, with a ticket tree per CPU. Draws on every CPU come from one
+// random sequence, so a run depends only on the seed.
+class LotteryRunQueue {
+public:
+    LotteryRunQueue(SmpShared& shared, int timeQuantum) : shared(&shared), timeQuantum(timeQuantum) {}
+
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+
+    void enqueue(int id, bool) {
+        tickets.insert(shared->table.processNumber(id), id, shared->table.workload.tickets[id]);
+        count++;
+    }
+    void requeue(int id) { enqueue(id, false); }
+    int pickNext() {
+        sliceLeft = timeQuantum;
+        return draw();
+    }
+    int detach() { return draw(); }
+    void attach(int id) { enqueue(id, true); }
+    void retire(int) {}
+    void charge(int, SimTime ran) { sliceLeft -= ran; }
+    SimTime sliceFor(int id) const { return min<SimTime>(sliceLeft, shared->table.remainingCpuBurst[id]); }
+    void renewSlice(int) { sliceLeft = timeQuantum; }
+    bool shouldPreempt(int) const { return false; }
+    void snapshot(Snapshot& snapshot) {
+        snapshot.io(tickets);
+        snapshot.io(count);
+        snapshot.io(sliceLeft);
+    }
+
+private:
+    SmpShared* shared;
+    int timeQuantum;
+    TicketTree tickets;
+    size_t count = 0;
+    SimTime sliceLeft = 0;
+
+    int draw() {
+        count--;
+        return tickets.take((long long)(nextRandom(shared->randomState) % (uint64_t)tickets.total()));
+    }
+};
+
+// Stride, with a global pass per CPU. A process that changes CPU has its
+// pass rebased onto the new CPU's global pass, as CFS does with vruntime.
+class StrideRunQueue {
+public:
+    StrideRunQueue(SmpShared& shared, int timeQuantum) : shared(&shared), timeQuantum(timeQuantum) {}
+
+    bool empty() const { return queue.empty(); }
+    size_t size() const { return queue.size(); }
+
+    void enqueue(int id, bool migrated) {
+        bool arriving = shared->table.currentCpuBurst[id] == 0;
+        if (arriving) {
+            coverProcesses(shared->pass, shared->table, 0LL);
+        }
+        long long& pass = shared->pass[id];
+        pass = migrated || arriving ? globalPass : max(pass, globalPass);
+        insert(id);
+    }
+    void requeue(int id) { insert(id); }
+    int pickNext() {
+        globalPass = max(globalPass, queue.topKey().pass);
+        sliceLeft = timeQuantum;
+        return queue.pop();
+    }
+    int detach() {
+        int id = queue.pop();
+        shared->pass[id] -= globalPass;
+        return id;
+    }
+    void attach(int id) {
+        shared->pass[id] += globalPass;
+        insert(id);
+    }
+    void retire(int) {}
+    void charge(int id, SimTime ran) {
+        shared->pass[id] += ran * ticketStride(shared->table.workload.tickets[id]);
+        sliceLeft -= ran;
+    }
+    SimTime sliceFor(int id) const { return min<SimTime>(sliceLeft, shared->table.remainingCpuBurst[id]); }
+    void renewSlice(int) { sliceLeft = timeQuantum; }
+    bool shouldPreempt(int) const { return false; }
+    void snapshot(Snapshot& snapshot) {
+        snapshot.io(queue);
+        snapshot.io(nextOrder);
+        snapshot.io(globalPass);
+        snapshot.io(sliceLeft);
+    }
+
+private:
+    SmpShared* shared;
+    int timeQuantum;
+    IndexedMinHeap<PassKey> queue;
+    long long nextOrder = 0;
+    long long globalPass = 0;
+    SimTime sliceLeft = 0;
+
+    void insert(int id) { queue.push(id, {shared->pass[id], nextOrder++}); }
+};
+
+void smpScheduling(const string& algorithm, ProcessTable& table, const SchedulerOptions& options, TraceSink& trace,
+                   Checkpointer* checkpointer) {
+    SmpShared shared(table, options);
+    if (algorithm == "FIFO" || algorithm == "RR") {
+        FifoRunQueue prototype(shared, algorithm == "RR" ? options.timeQuantum : 0);
+        SmpSimulation<FifoRunQueue>(table, options.smp, prototype, shared, trace, checkpointer).run();
+    } else if (algorithm == "SJF" || algorithm == "SRTF") {
+        BurstRunQueue prototype(shared, algorithm == "SRTF");
+        SmpSimulation<BurstRunQueue>(table, options.smp, prototype, shared, trace, checkpointer).run();
+    } else if (algorithm == "CFS") {
+        shared.vruntime.assign(table.size(), 0);
+        CfsRunQueue prototype(shared);
+        SmpSimulation<CfsRunQueue>(table, options.smp, prototype, shared, trace, checkpointer).run();
+    } else if (algorithm == "MLFQ") {
+        MlfqPriorities priorities(options.mlfq, table.size());
+        shared.mlfqLinks.assign(table.size(), -1);
+        shared.mlfq = &priorities;
+        MlfqRunQueue prototype(shared);
+        SmpSimulation<MlfqRunQueue>(table, options.smp, prototype, shared, trace, checkpointer).run();
+    } else if (algorithm == "LOTTERY") {
+        shared.randomState = options.lotterySeed;
+        LotteryRunQueue prototype(shared, options.timeQuantum);
+        SmpSimulation<LotteryRunQueue>(table, options.smp, prototype, shared, trace, checkpointer).run();
+    } else if (algorithm == "STRIDE") {
+        shared.pass.assign(table.size(), 0);
+        StrideRunQueue prototype(shared, options.timeQuantum);
+        SmpSimulation<StrideRunQueue>(table, options.smp, prototype, shared, trace, checkpointer).run();
+    }
+}
@@ -0,0 +1,17 @@
+#ifndef SMP_H
+#define SMP_H
+
+#include <string>
+#include "schedulers.h"
+
+// Run a scheduler on options.smp.cpus CPUs. Every CPU has its own run queue
+// ordered by the named policy. New processes go to an idle CPU if there is
+// one, else to the least loaded; woken processes go back to the CPU they
+// last ran on unless it is busy and another is idle. A CPU that runs out of
+// work steals from the longest queue, and every balanceInterval time units
+// queues differing by two or more are evened out. Per-CPU busy time,
+// dispatches and migrations are left in table.cpuStats.
+void smpScheduling(const std::string& algorithm, ProcessTable& table, const SchedulerOptions& options, TraceSink& trace,
+                   Checkpointer* checkpointer = nullptr);
+
+#endif
@@ -0,0 +1,104 @@
+#include "sweep.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include "thread_pool.h"
+using namespace std;
+
+bool parseQuantumList(const string& spec, vector<int>& quanta) {
+    quanta.clear();
+    size_t start = 0;
+    while (start <= spec.size()) {
+        size_t comma = spec.find(',', start);
+        string item = spec.substr(start, comma == string::npos ? string::npos : comma - start);
+        size_t dash = item.find('-');
+        try {
+            size_t used;
+            int first = stoi(item.substr(0, dash), &used);
+            if (used != (dash == string::npos ? item.size() : dash)) {
+                return false;
+            }
+            int last = first;
+            if (dash != string::npos) {
+                string rest = item.substr(dash + 1);
+                last = stoi(rest, &used);
+                if (used != rest.size()) {
+                    return false;
+                }
+            }
+            if (first <= 0 || last < first) {
+                return false;
+            }
+            for (int quantum = first; quantum <= last; quantum++) {
+                quanta.push_back(quantum);
+            }
+        } catch (const exception&) {
+            return false;
+        }
+        if (comma == string::npos) {
+            break;
+        }
+        start = comma + 1;
+    }
+    return !quanta.empty();
+}
+
+void runSweep(const Workload& workload, const SweepOptions& options, ostream& out) {
+    struct SweepRun {
+        string algorithm;
+        int timeQuantum;
+        RunSummary summary;
+    };
+
+    // Only RR, LOTTERY and STRIDE depend on the quantum; everything else runs once
+    vector<SweepRun> runs;
+    for (const string& algorithm : options.algorithms) {
+        if (usesTimeQuantum(algorithm)) {
+            for (int quantum : options.quanta) {
+                runs.push_back({algorithm, quantum, RunSummary()});
+            }
+        } else {
+            runs.push_back({algorithm, 0, RunSummary()});
+        }
+    }
+
+    auto start = chrono::steady_clock::now();
+    unsigned threadCount;
+    {
+        ThreadPool pool(options.threads);
+        threadCount = pool.size();
+        for (SweepRun& run : runs) {
+            pool.submit([&workload, &options, &run] {
+                // The workload is shared read-only; each run owns its state,
+                // in an arena that the worker reuses for all of its runs
+                static thread_local RunArena arena;
+                RunArena::Scope scope(arena);
+                ProcessTable table(workload);
+                SchedulerOptions schedulerOptions = options.scheduler;
+                schedulerOptions.timeQuantum = run.timeQuantum;
+                TraceSink silent(TRACE_OFF);
+                runScheduler(run.algorithm, table, schedulerOptions, silent);
+                run.summary = summarizeRun(table);
+            });
+        }
+        pool.wait();
+    }
+    double elapsedMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    out << "Algorithm\tQuantum\tATAT\t\tAWT\t\tMakespan\n";
+    for (const SweepRun& run : runs) {
+        out << run.algorithm << "\t";
+        if (usesTimeQuantum(run.algorithm)) {
+            out << run.timeQuantum;
+        } else {
+            out << "-";
+        }
+        out << "\t" << setw(8) << run.summary.averageTurnaroundTime << "\t"
+            << setw(8) << run.summary.averageWaitingTime << "\t"
+            << run.summary.makespan << "\n";
+    }
+    out << flush;
+    // Timing varies from run to run, so it stays out of the table
+    cerr << runs.size() << " runs on " << threadCount << " threads in " << elapsedMs << " ms" << endl;
+}
@@ -0,0 +1,25 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include "schedulers.h"
+#include "workload.h"
+
+struct SweepOptions {
+    std::vector<std::string> algorithms = {"FIFO", "SJF", "SRTF", "CFS", "RR", "MLFQ"};
+    std::vector<int> quanta;   // Time quanta to try with RR, LOTTERY and STRIDE
+    SchedulerOptions scheduler; // Settings shared by every run, e.g. the CFS tunables
+    unsigned threads = 0;       // 0 means one per core
+};
+
+// Parse a quantum list such as "1-200" or "2,4,8,16-20"
+bool parseQuantumList(const std::string& spec, std::vector<int>& quanta);
+
+// Run every (algorithm, quantum) combination on the shared, read-only
+// workload in parallel and write one results table to out; the run count
+// and wall-clock time go to stderr, so tables for the same workload match
+void runSweep(const Workload& workload, const SweepOptions& options, std::ostream& out);
+
+#endif
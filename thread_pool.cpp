@@ -0,0 +1,99 @@
+#include "thread_pool.h"
+
+using namespace std;
+
+ThreadPool::ThreadPool(unsigned numThreads) {
+    if (numThreads == 0) {
+        numThreads = max(1u, thread::hardware_concurrency());
+    }
+    for (unsigned i = 0; i < numThreads; i++) {
+        queues.emplace_back(new WorkerQueue());
+    }
+    for (unsigned i = 0; i < numThreads; i++) {
+        threads.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard<mutex> guard(stateLock);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (thread& worker : threads) {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(function<void()> task) {
+    // Count the task before it becomes visible, so a worker can never take
+    // it before it has been counted
+    unsigned target;
+    {
+        lock_guard<mutex> guard(stateLock);
+        target = nextQueue++ % queues.size();
+        queuedTasks++;
+        unfinishedTasks++;
+    }
+    {
+        lock_guard<mutex> guard(queues[target]->lock);
+        queues[target]->tasks.push_back(move(task));
+    }
+    workAvailable.notify_one();
+}
+
+void ThreadPool::wait() {
+    unique_lock<mutex> guard(stateLock);
+    allDone.wait(guard, [&] { return unfinishedTasks == 0; });
+}
+
+bool ThreadPool::takeTask(unsigned worker, function<void()>& task) {
+    // Own queue first, newest task first
+    {
+        WorkerQueue& own = *queues[worker];
+        lock_guard<mutex> guard(own.lock);
+        if (!own.tasks.empty()) {
+            task = move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    // Then steal the oldest task of another worker
+    for (size_t i = 1; i < queues.size(); i++) {
+        WorkerQueue& victim = *queues[(worker + i) % queues.size()];
+        lock_guard<mutex> guard(victim.lock);
+        if (!victim.tasks.empty()) {
+            task = move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(unsigned worker) {
+    while (true) {
+        function<void()> task;
+        if (takeTask(worker, task)) {
+            {
+                lock_guard<mutex> guard(stateLock);
+                queuedTasks--;
+            }
+            task();
+            lock_guard<mutex> guard(stateLock);
+            if (--unfinishedTasks == 0) {
+                allDone.notify_all();
+            }
+            continue;
+        }
+
+        unique_lock<mutex> guard(stateLock);
+        if (stopping && queuedTasks == 0) {
+            return;
+        }
+        workAvailable.wait(guard, [&] { return stopping || queuedTasks > 0; });
+        if (stopping && queuedTasks == 0) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size pool of worker threads. Every worker owns a task deque: it
+// takes work from the back of its own deque and, once that is empty,
+// steals from the front of the others, so uneven tasks (a CFS run next to
+// a FIFO run) still keep every core busy.
+class ThreadPool {
+public:
+    // numThreads == 0 means one thread per hardware core
+    explicit ThreadPool(unsigned numThreads = 0);
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ~ThreadPool();
+
+    void submit(std::function<void()> task);
+
+    // Block until every submitted task has finished
+    void wait();
+
+    unsigned size() const { return (unsigned)threads.size(); }
+
+private:
+    struct WorkerQueue {
+        std::mutex lock;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> threads;
+
+    std::mutex stateLock;
+    std::condition_variable workAvailable;
+    std::condition_variable allDone;
+    size_t queuedTasks = 0;     // Submitted but not yet taken by a worker
+    size_t unfinishedTasks = 0; // Submitted but not yet finished
+    size_t nextQueue = 0;
+    bool stopping = false;
+
+    bool takeTask(unsigned worker, std::function<void()>& task);
+    void workerLoop(unsigned worker);
+};
+
+#endif
@@ -0,0 +1,228 @@
+#include "timeline.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <tuple>
+using namespace std;
+
+// Binary timelines: this header, then the start and end columns as int64
+// and the process, CPU and burst columns as int32, each `intervals` long.
+// Process and burst numbers are 0-based. Integers are in host byte order.
+const char TIMELINE_MAGIC[8] = {'S', 'C', 'H', 'E', 'D', 'T', 'L', 'N'};
+const uint32_t TIMELINE_VERSION = 1;
+const uint32_t TIMELINE_BYTE_ORDER_MARK = 0x01020304;
+
+struct TimelineFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrderMark;
+    uint64_t intervals;
+};
+
+// Text output is handed to stdio once it grows past this size
+const size_t TIMELINE_BUFFER_SIZE = 1 << 20;
+
+bool parseTimelineFormat(const string& name, TimelineFormat& format) {
+    if (name == "chrome") {
+        format = TIMELINE_CHROME;
+    } else if (name == "csv") {
+        format = TIMELINE_CSV;
+    } else if (name == "binary") {
+        format = TIMELINE_BINARY;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+Timeline::Timeline(size_t expectedIntervals) : lastOnCpu(1, -1) {
+    start.reserve(expectedIntervals);
+    end.reserve(expectedIntervals);
+    process.reserve(expectedIntervals);
+    cpu.reserve(expectedIntervals);
+    burst.reserve(expectedIntervals);
+}
+
+void Timeline::record(int cpuIndex, SimTime from, int processID, int burstIndex, SimTime length) {
+    if (cpuIndex < 0) {
+        cpuIndex = 0;
+    }
+    if ((size_t)cpuIndex >= lastOnCpu.size()) {
+        lastOnCpu.resize(cpuIndex + 1, -1);
+    }
+    long long last = lastOnCpu[cpuIndex];
+    if (last >= 0 && end[last] == from && process[last] == processID && burst[last] == burstIndex) {
+        end[last] += length;
+        return;
+    }
+    lastOnCpu[cpuIndex] = (long long)start.size();
+    start.push_back(from);
+    end.push_back(from + length);
+    process.push_back(processID);
+    cpu.push_back(cpuIndex);
+    burst.push_back(burstIndex);
+}
+
+Timeline Timeline::downsample(SimTime window) const {
+    // The window being gathered on each CPU, with the time each
+    // (process, burst) ran in it
+    struct OpenWindow {
+        long long index = -1;
+        SimTime first = 0;
+        SimTime last = 0;
+        vector<tuple<int32_t, int32_t, SimTime>> shares;
+    };
+    Timeline sampled;
+    vector<OpenWindow> windows(lastOnCpu.size());
+
+    auto close = [&](int c) {
+        OpenWindow& open = windows[c];
+        if (open.index < 0) {
+            return;
+        }
+        auto longest = max_element(open.shares.begin(), open.shares.end(),
+                                    [](const auto& a, const auto& b) { return get<2>(a) < get<2>(b); });
+        sampled.record(c, open.first, get<0>(*longest), get<1>(*longest), open.last - open.first);
+        open.index = -1;
+        open.shares.clear();
+    };
+
+    for (size_t i = 0; i < size(); i++) {
+        int c = cpu[i];
+        OpenWindow& open = windows[c];
+        // An interval is split at window boundaries
+        for (SimTime from = start[i]; from < end[i];) {
+            long long index = from / window;
+            SimTime to = min(end[i], (index + 1) * window);
+            if (open.index != index) {
+                close(c);
+                open.index = index;
+                open.first = from;
+            }
+            open.last = to;
+            auto share = find_if(open.shares.begin(), open.shares.end(), [&](const auto& entry) {
+                return get<0>(entry) == process[i] && get<1>(entry) == burst[i];
+            });
+            if (share != open.shares.end()) {
+                get<2>(*share) += to - from;
+            } else {
+                open.shares.emplace_back(process[i], burst[i], to - from);
+            }
+            from = to;
+        }
+    }
+    for (size_t c = 0; c < windows.size(); c++) {
+        close((int)c);
+    }
+    return sampled;
+}
+
+static void appendNumber(string& buffer, long long value) {
+    char digits[24];
+    char* end = to_chars(digits, digits + sizeof(digits), value).ptr;
+    buffer.append(digits, end);
+}
+
+static void flushIfFull(string& buffer, FILE* out) {
+    if (buffer.size() >= TIMELINE_BUFFER_SIZE) {
+        fwrite(buffer.data(), 1, buffer.size(), out);
+        buffer.clear();
+    }
+}
+
+// One complete ("X") event per interval on thread `cpu` of a single
+// process, so each CPU is a row; one time unit is shown as a microsecond
+static void writeChrome(const Timeline& timeline, FILE* out) {
+    string buffer;
+    buffer.reserve(TIMELINE_BUFFER_SIZE + 256);
+    buffer += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    int cpus = timeline.size() ? *max_element(timeline.cpu.begin(), timeline.cpu.end()) + 1 : 0;
+    for (int c = 0; c < cpus; c++) {
+        buffer += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":";
+        appendNumber(buffer, c);
+        buffer += ",\"args\":{\"name\":\"CPU ";
+        appendNumber(buffer, c);
+        buffer += "\"}},\n";
+    }
+    for (size_t i = 0; i < timeline.size(); i++) {
+        buffer += "{\"name\":\"P";
+        appendNumber(buffer, timeline.process[i] + 1);
+        buffer += "\",\"ph\":\"X\",\"pid\":0,\"tid\":";
+        appendNumber(buffer, timeline.cpu[i]);
+        buffer += ",\"ts\":";
+        appendNumber(buffer, timeline.start[i]);
+        buffer += ",\"dur\":";
+        appendNumber(buffer, timeline.end[i] - timeline.start[i]);
+        buffer += ",\"args\":{\"burst\":";
+        appendNumber(buffer, timeline.burst[i] + 1);
+        buffer += "}},\n";
+        flushIfFull(buffer, out);
+    }
+    // JSON allows no trailing comma, so the list ends with the process's name
+    buffer += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"Schedule\"}}\n]}\n";
+    fwrite(buffer.data(), 1, buffer.size(), out);
+}
+
+// Process and burst numbers are written 1-based, as in the dispatch trace
+static void writeCsv(const Timeline& timeline, FILE* out) {
+    string buffer;
+    buffer.reserve(TIMELINE_BUFFER_SIZE + 256);
+    buffer += "start,end,process,cpu,burst\n";
+    for (size_t i = 0; i < timeline.size(); i++) {
+        appendNumber(buffer, timeline.start[i]);
+        buffer += ',';
+        appendNumber(buffer, timeline.end[i]);
+        buffer += ',';
+        appendNumber(buffer, timeline.process[i] + 1);
+        buffer += ',';
+        appendNumber(buffer, timeline.cpu[i]);
+        buffer += ',';
+        appendNumber(buffer, timeline.burst[i] + 1);
+        buffer += '\n';
+        flushIfFull(buffer, out);
+    }
+    fwrite(buffer.data(), 1, buffer.size(), out);
+}
+
+static void writeBinary(const Timeline& timeline, FILE* out) {
+    TimelineFileHeader header = {};
+    memcpy(header.magic, TIMELINE_MAGIC, sizeof(TIMELINE_MAGIC));
+    header.version = TIMELINE_VERSION;
+    header.byteOrderMark = TIMELINE_BYTE_ORDER_MARK;
+    header.intervals = timeline.size();
+    fwrite(&header, sizeof(header), 1, out);
+    fwrite(timeline.start.data(), sizeof(SimTime), timeline.size(), out);
+    fwrite(timeline.end.data(), sizeof(SimTime), timeline.size(), out);
+    fwrite(timeline.process.data(), sizeof(int32_t), timeline.size(), out);
+    fwrite(timeline.cpu.data(), sizeof(int32_t), timeline.size(), out);
+    fwrite(timeline.burst.data(), sizeof(int32_t), timeline.size(), out);
+}
+
+bool Timeline::write(const string& path, TimelineFormat format) const {
+    FILE* out = fopen(path.c_str(), format == TIMELINE_BINARY ? "wb" : "w");
+    if (!out) {
+        cerr << path << ": " << strerror(errno) << endl;
+        return false;
+    }
+    switch (format) {
+    case TIMELINE_CHROME:
+        writeChrome(*this, out);
+        break;
+    case TIMELINE_CSV:
+        writeCsv(*this, out);
+        break;
+    case TIMELINE_BINARY:
+        writeBinary(*this, out);
+        break;
+    }
+    bool ok = !ferror(out);
+    if (fclose(out) != 0 || !ok) {
+        cerr << path << ": write failed" << endl;
+        return false;
+    }
+    return true;
+}
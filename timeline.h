@@ -0,0 +1,51 @@
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "simulator.h"
+
+enum TimelineFormat {
+    TIMELINE_CHROME, // Chrome trace-event JSON, for chrome://tracing or Perfetto
+    TIMELINE_CSV,    // One interval per line
+    TIMELINE_BINARY, // The columns as raw arrays
+};
+
+bool parseTimelineFormat(const std::string& name, TimelineFormat& format);
+
+// Gantt chart of a run: one interval per stretch of a CPU burst that held a
+// CPU without a break. Intervals are kept column by column in vectors sized
+// up front, 28 bytes each, and a slice that continues the previous interval
+// on its CPU (same process and burst, starting where it ended) extends it
+// instead of adding one. On each CPU intervals are in time order; across
+// CPUs they are in the order they were recorded.
+class Timeline {
+public:
+    // Room for expectedIntervals before the columns have to grow
+    explicit Timeline(size_t expectedIntervals = 0);
+
+    // processID ran CPU burst burstIndex (both 0-based) on cpuIndex (-1 on
+    // a uniprocessor, recorded as CPU 0) for `length` units from `from`
+    void record(int cpuIndex, SimTime from, int processID, int burstIndex, SimTime length);
+
+    size_t size() const { return start.size(); }
+
+    // At most one interval per CPU per `window` time units: the process that
+    // ran longest in the window, spanning the window's busy time
+    Timeline downsample(SimTime window) const;
+
+    // Problems go to stderr
+    bool write(const std::string& path, TimelineFormat format) const;
+
+    std::vector<SimTime> start;
+    std::vector<SimTime> end;
+    std::vector<int32_t> process;
+    std::vector<int32_t> cpu;
+    std::vector<int32_t> burst;
+
+private:
+    std::vector<long long> lastOnCpu; // Index of each CPU's latest interval, -1 before the first
+};
+
+#endif
@@ -0,0 +1,207 @@
+#include "trace.h"
+
+#include <charconv>
+#include "profile.h"
+#include "timeline.h"
+using namespace std;
+
+// Buffered output is handed to stdio once it grows past this size
+const size_t TRACE_BUFFER_SIZE = 1 << 20;
+
+bool parseTraceLevel(const string& name, TraceLevel& level) {
+    if (name == "off") {
+        level = TRACE_OFF;
+    } else if (name == "summary") {
+        level = TRACE_SUMMARY;
+    } else if (name == "dispatch") {
+        level = TRACE_DISPATCH;
+    } else if (name == "tick") {
+        level = TRACE_TICK;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool parseTraceFormat(const string& name, TraceFormat& format) {
+    if (name == "text") {
+        format = TRACE_TEXT;
+    } else if (name == "csv") {
+        format = TRACE_CSV;
+    } else if (name == "jsonl") {
+        format = TRACE_JSONL;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+TraceSink::TraceSink(TraceLevel level, TraceFormat format, FILE* out)
+    : traceLevel(level), format(format), out(out) {
+    if (traceLevel >= TRACE_DISPATCH) {
+        buffer.reserve(TRACE_BUFFER_SIZE + 256);
+    }
+}
+
+void TraceSink::flush() {
+    PROFILE_SCOPE(PHASE_TRACE);
+    if (hasPending) {
+        writePending();
+    }
+    if (!buffer.empty()) {
+        fwrite(buffer.data(), 1, buffer.size(), out);
+        buffer.clear();
+    }
+    if (traceLevel >= TRACE_DISPATCH) {
+        fflush(out);
+    }
+}
+
+void TraceSink::recordDispatch(int cpu, SimTime start, int processID, int burst, SimTime length, long long slices, bool reportLength) {
+    PROFILE_SCOPE(PHASE_TRACE);
+    if (processNumbers) {
+        processID = (*processNumbers)[processID];
+    }
+    if (traceLevel >= TRACE_TICK) {
+        // One record per time unit, never merged
+        for (SimTime t = start; t < start + length; t++) {
+            writeDispatch({cpu, t, processID, burst, 1, 1, true});
+        }
+        maybeFlushBuffer();
+        return;
+    }
+
+    if (hasPending && pending.cpu == cpu && pending.processID == processID && pending.burst == burst &&
+        pending.start + pending.length == start) {
+        pending.length += length;
+        pending.slices += slices;
+        return;
+    }
+    if (hasPending) {
+        writePending();
+    }
+    pending = {cpu, start, processID, burst, length, slices, reportLength};
+    hasPending = true;
+}
+
+void TraceSink::addToTimeline(int cpu, SimTime start, int processID, int burst, SimTime length) {
+    PROFILE_SCOPE(PHASE_TRACE);
+    if (processNumbers) {
+        processID = (*processNumbers)[processID];
+    }
+    timeline->record(cpu, start, processID, burst, length);
+}
+
+void TraceSink::recordIdle(SimTime time) {
+    PROFILE_SCOPE(PHASE_TRACE);
+    if (hasPending) {
+        writePending();
+    }
+    switch (format) {
+    case TRACE_TEXT:
+        buffer += "No process ready at time ";
+        appendNumber(time);
+        buffer += ". Advancing time.\n";
+        break;
+    case TRACE_CSV:
+        if (!wroteHeader) {
+            buffer += "event,time,process,burst,length,slices,cpu\n";
+            wroteHeader = true;
+        }
+        buffer += "idle,";
+        appendNumber(time);
+        buffer += ",,,,,\n";
+        break;
+    case TRACE_JSONL:
+        buffer += "{\"event\":\"idle\",\"time\":";
+        appendNumber(time);
+        buffer += "}\n";
+        break;
+    }
+    maybeFlushBuffer();
+}
+
+void TraceSink::writePending() {
+    writeDispatch(pending);
+    hasPending = false;
+    maybeFlushBuffer();
+}
+
+// Process and burst numbers are written 1-based, as in the text trace
+void TraceSink::writeDispatch(const PendingDispatch& dispatch) {
+    switch (format) {
+    case TRACE_TEXT:
+        if (dispatch.cpu >= 0) {
+            buffer += "CPU ";
+            appendNumber(dispatch.cpu);
+            buffer += ": ";
+        }
+        buffer += "Executing Process ";
+        appendNumber(dispatch.processID + 1);
+        buffer += ", CPU Burst ";
+        appendNumber(dispatch.burst + 1);
+        if (dispatch.reportLength) {
+            buffer += " for ";
+            appendNumber(dispatch.length);
+            buffer += " units";
+            if (dispatch.slices > 1) {
+                buffer += " (";
+                appendNumber(dispatch.slices);
+                buffer += " slices)";
+            }
+        }
+        buffer += '\n';
+        break;
+    case TRACE_CSV:
+        if (!wroteHeader) {
+            buffer += "event,time,process,burst,length,slices,cpu\n";
+            wroteHeader = true;
+        }
+        buffer += "dispatch,";
+        appendNumber(dispatch.start);
+        buffer += ',';
+        appendNumber(dispatch.processID + 1);
+        buffer += ',';
+        appendNumber(dispatch.burst + 1);
+        buffer += ',';
+        appendNumber(dispatch.length);
+        buffer += ',';
+        appendNumber(dispatch.slices);
+        buffer += ',';
+        if (dispatch.cpu >= 0) {
+            appendNumber(dispatch.cpu);
+        }
+        buffer += '\n';
+        break;
+    case TRACE_JSONL:
+        buffer += "{\"event\":\"dispatch\",\"time\":";
+        appendNumber(dispatch.start);
+        buffer += ",\"process\":";
+        appendNumber(dispatch.processID + 1);
+        buffer += ",\"burst\":";
+        appendNumber(dispatch.burst + 1);
+        buffer += ",\"length\":";
+        appendNumber(dispatch.length);
+        buffer += ",\"slices\":";
+        appendNumber(dispatch.slices);
+        if (dispatch.cpu >= 0) {
+            buffer += ",\"cpu\":";
+            appendNumber(dispatch.cpu);
+        }
+        buffer += "}\n";
+        break;
+    }
+}
+
+void TraceSink::appendNumber(long long value) {
+    char digits[24];
+    char* end = to_chars(digits, digits + sizeof(digits), value).ptr;
+    buffer.append(digits, end);
+}
+
+void TraceSink::maybeFlushBuffer() {
+    if (buffer.size() >= TRACE_BUFFER_SIZE) {
+        fwrite(buffer.data(), 1, buffer.size(), out);
+        buffer.clear();
+    }
+}
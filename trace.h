@@ -0,0 +1,110 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "simulator.h"
+
+class Timeline;
+
+enum TraceLevel {
+    TRACE_OFF,      // Nothing at all
+    TRACE_SUMMARY,  // Only the final metrics
+    TRACE_DISPATCH, // Plus one record per dispatch and idle gap
+    TRACE_TICK,     // Plus one record per simulated time unit
+};
+
+enum TraceFormat { TRACE_TEXT, TRACE_CSV, TRACE_JSONL };
+
+bool parseTraceLevel(const std::string& name, TraceLevel& level);
+bool parseTraceFormat(const std::string& name, TraceFormat& format);
+
+// Destination for the scheduling trace. Records are formatted into a large
+// buffer that is written out in big chunks rather than flushed per line.
+// At dispatch level, back-to-back slices of the same CPU burst (a process
+// that keeps the CPU across a quantum or an event) are merged into one
+// record carrying the number of slices.
+class TraceSink {
+public:
+    // Writes to out, which is not closed; level TRACE_OFF never touches it
+    explicit TraceSink(TraceLevel level = TRACE_OFF, TraceFormat format = TRACE_TEXT, FILE* out = stdout);
+    TraceSink(const TraceSink&) = delete;
+    TraceSink& operator=(const TraceSink&) = delete;
+    ~TraceSink() { flush(); }
+
+    TraceLevel level() const { return traceLevel; }
+    bool enabled(TraceLevel minimum) const { return traceLevel >= minimum; }
+
+    // processID ran CPU burst `burst` (both 0-based) for `length` units from
+    // `start`. Text output names the length unless reportLength is false,
+    // which the run-to-completion schedulers use.
+    void dispatch(SimTime start, int processID, int burst, SimTime length, bool reportLength = true) {
+        if (traceLevel >= TRACE_DISPATCH) {
+            recordDispatch(-1, start, processID, burst, length, 1, reportLength);
+        }
+        if (timeline) {
+            addToTimeline(-1, start, processID, burst, length);
+        }
+    }
+
+    // Multi-CPU runs: processID held `cpu` for `length` units from `start`,
+    // over `slices` consecutive slices. Records arrive in the order the
+    // processes leave their CPUs, not by start time.
+    void cpuDispatch(int cpu, SimTime start, int processID, int burst, SimTime length, long long slices) {
+        if (traceLevel >= TRACE_DISPATCH) {
+            recordDispatch(cpu, start, processID, burst, length, slices, true);
+        }
+        if (timeline) {
+            addToTimeline(cpu, start, processID, burst, length);
+        }
+    }
+
+    // Nothing was runnable; the clock jumped to `time`
+    void idle(SimTime time) {
+        if (traceLevel >= TRACE_DISPATCH) {
+            recordIdle(time);
+        }
+    }
+
+    // Streaming runs: the IDs passed in are slots, recorded as the process
+    // number each slot holds at the time
+    void useProcessNumbers(const std::vector<int>* numbers) { processNumbers = numbers; }
+
+    // Also record every dispatch, at any trace level, into `timeline`
+    void recordTimeline(Timeline* timeline) { this->timeline = timeline; }
+
+    // Write out everything recorded so far
+    void flush();
+
+private:
+    struct PendingDispatch {
+        int cpu; // -1 on a uniprocessor
+        SimTime start;
+        int processID;
+        int burst;
+        SimTime length;
+        long long slices;
+        bool reportLength;
+    };
+
+    TraceLevel traceLevel;
+    TraceFormat format;
+    FILE* out;
+    std::string buffer;
+    bool hasPending = false;
+    bool wroteHeader = false;
+    PendingDispatch pending;
+    const std::vector<int>* processNumbers = nullptr;
+    Timeline* timeline = nullptr;
+
+    void recordDispatch(int cpu, SimTime start, int processID, int burst, SimTime length, long long slices, bool reportLength);
+    void recordIdle(SimTime time);
+    void addToTimeline(int cpu, SimTime start, int processID, int burst, SimTime length);
+    void writePending();
+    void writeDispatch(const PendingDispatch& dispatch);
+    void appendNumber(long long value);
+    void maybeFlushBuffer();
+};
+
+#endif
@@ -0,0 +1,587 @@
+#include "workload.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <climits>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+using namespace std;
+
+MappedFile::~MappedFile() {
+    if (mapped) {
+        munmap((void*)begin, length);
+    }
+}
+
+bool MappedFile::open(const string& path, string& error) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = strerror(errno);
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode)) {
+        length = info.st_size;
+        if (length > 0) {
+            void* address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (address != MAP_FAILED) {
+                madvise(address, length, MADV_SEQUENTIAL);
+                begin = (const char*)address;
+                mapped = true;
+                close(fd);
+                return true;
+            }
+        }
+    }
+
+    // Pipes, character devices and anything mmap refuses are read into memory
+    char buffer[1 << 16];
+    ssize_t count;
+    while ((count = read(fd, buffer, sizeof(buffer))) > 0) {
+        fallback.append(buffer, count);
+    }
+    close(fd);
+    if (count < 0) {
+        error = strerror(errno);
+        return false;
+    }
+    begin = fallback.data();
+    length = fallback.size();
+    return true;
+}
+
+// Skip spaces, tabs and carriage returns within the current line
+static const char* skipBlanks(const char* p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) {
+        p++;
+    }
+    return p;
+}
+
+static const char* tokenEnd(const char* p, const char* end) {
+    while (p < end && *p != ' ' && *p != '\t' && *p != '\r') {
+        p++;
+    }
+    return p;
+}
+
+// Parse a whole-token decimal integer starting at p. Returns the end of the
+// token, or nullptr if the token is not an integer or does not fit an int.
+static const char* parseInt(const char* p, const char* end, int& value) {
+    bool negative = p < end && *p == '-';
+    p += negative;
+    const char* digits = p;
+    long long result = 0;
+    while (p < end) {
+        unsigned digit = (unsigned char)*p - '0';
+        if (digit > 9) {
+            break;
+        }
+        result = result * 10 + digit;
+        if (result > INT_MAX) {
+            return nullptr;
+        }
+        p++;
+    }
+    if (p == digits || tokenEnd(p, end) != p) {
+        return nullptr;
+    }
+    value = negative ? -(int)result : (int)result;
+    return p;
+}
+
+void Workload::useOwnedStorage() {
+    numProcesses = ownedArrivalTime.size();
+    arrivalTime = ownedArrivalTime.data();
+    numCpuBursts = ownedNumCpuBursts.data();
+    totalCpuBurstTime = ownedTotalCpuBurstTime.data();
+    nice = ownedNice.data();
+    tickets = ownedTickets.data();
+    device = ownedDevice.data();
+    burstOffset = ownedBurstOffset.data();
+    burstStream = ownedBurstStream.data();
+    burstStreamSize = ownedBurstStream.size();
+}
+
+bool parseProcessLine(const char* q, const char* lineEnd, vector<uint8_t>& stream, ProcessRecord& record, string& error) {
+    int arrivalTime;
+    const char* next = parseInt(q, lineEnd, arrivalTime);
+    if (!next || arrivalTime < 0) {
+        error = "expected a non-negative arrival time but found '" + string(q, tokenEnd(q, lineEnd)) + "'";
+        return false;
+    }
+    q = next;
+
+    // Bursts, alternating CPU and I/O, up to the -1 terminator
+    size_t burstStart = stream.size();
+    auto fail = [&](const string& message) {
+        error = message;
+        stream.resize(burstStart);
+        return false;
+    };
+    int numBursts = 0;
+    long long totalCpuBurstTime = 0;
+    bool terminated = false;
+    while ((q = skipBlanks(q, lineEnd)) < lineEnd) {
+        int burst;
+        next = parseInt(q, lineEnd, burst);
+        if (!next || burst < -1) {
+            return fail("expected a burst length or -1 but found '" + string(q, tokenEnd(q, lineEnd)) + "'");
+        }
+        q = next;
+        if (burst == -1) {
+            terminated = true;
+            break;
+        }
+        if (numBursts % 2 == 0) {
+            totalCpuBurstTime += burst;
+        }
+        appendVarint(stream, burst);
+        numBursts++;
+    }
+
+    if (!terminated) {
+        return fail("missing -1 terminator");
+    } else if (numBursts == 0) {
+        return fail("process has no CPU bursts");
+    } else if (numBursts % 2 == 0) {
+        return fail("burst list ends with an I/O burst instead of a CPU burst");
+    } else if (totalCpuBurstTime > INT_MAX) {
+        return fail("total CPU time does not fit in an int");
+    }
+
+    // Optional key=value attributes after the -1
+    int nice = 0;
+    int tickets = DEFAULT_TICKETS;
+    int device = 0;
+    while ((q = skipBlanks(q, lineEnd)) < lineEnd) {
+        const char* attributeEnd = tokenEnd(q, lineEnd);
+        string attribute(q, attributeEnd);
+        int value;
+        if (attribute.rfind("nice=", 0) == 0 && parseInt(q + 5, attributeEnd, value)) {
+            if (value < -20 || value > 19) {
+                return fail("nice must be between -20 and 19 but is " + to_string(value));
+            }
+            nice = value;
+        } else if (attribute.rfind("tickets=", 0) == 0 && parseInt(q + 8, attributeEnd, value)) {
+            if (value < 1 || value > MAX_TICKETS) {
+                return fail("tickets must be between 1 and " + to_string(MAX_TICKETS) + " but is " + to_string(value));
+            }
+            tickets = value;
+        } else if (attribute.rfind("dev=", 0) == 0 && parseInt(q + 4, attributeEnd, value)) {
+            if (value < 0 || value >= MAX_DEVICES) {
+                return fail("dev must be between 0 and " + to_string(MAX_DEVICES - 1) + " but is " + to_string(value));
+            }
+            device = value;
+        } else {
+            return fail("unrecognised attribute '" + attribute + "'");
+        }
+        q = attributeEnd;
+    }
+
+    record.arrivalTime = arrivalTime;
+    record.numCpuBursts = (numBursts + 1) / 2;
+    record.totalCpuBurstTime = (int32_t)totalCpuBurstTime;
+    record.nice = (int8_t)nice;
+    record.tickets = tickets;
+    record.device = (uint8_t)device;
+    return true;
+}
+
+static bool parseTextWorkload(const string& filePath, const char* p, const char* end, Workload& workload) {
+    const int MAX_REPORTED_ERRORS = 20;
+
+    size_t lineCount = 0;
+    for (const char* scan = p; scan < end; lineCount++) {
+        const char* newline = (const char*)memchr(scan, '\n', end - scan);
+        scan = newline ? newline + 1 : end;
+    }
+    workload.ownedArrivalTime.reserve(lineCount);
+    workload.ownedNumCpuBursts.reserve(lineCount);
+    workload.ownedTotalCpuBurstTime.reserve(lineCount);
+    workload.ownedNice.reserve(lineCount);
+    workload.ownedTickets.reserve(lineCount);
+    workload.ownedDevice.reserve(lineCount);
+    workload.ownedBurstOffset.reserve(lineCount);
+    vector<uint8_t>& stream = workload.ownedBurstStream;
+
+    int lineNumber = 0;
+    int errorCount = 0;
+    string error;
+    ProcessRecord record;
+
+    while (p < end) {
+        const char* newline = (const char*)memchr(p, '\n', end - p);
+        const char* lineEnd = newline ? newline : end;
+        const char* q = skipBlanks(p, lineEnd);
+        p = newline ? newline + 1 : end;
+        lineNumber++;
+
+        if (q == lineEnd) {
+            continue; // Blank line
+        }
+
+        size_t burstStart = stream.size();
+        if (!parseProcessLine(q, lineEnd, stream, record, error)) {
+            if (errorCount < MAX_REPORTED_ERRORS) {
+                cerr << filePath << ":" << lineNumber << ": " << error << endl;
+            } else if (errorCount == MAX_REPORTED_ERRORS) {
+                cerr << filePath << ": too many errors, giving up on reporting" << endl;
+            }
+            errorCount++;
+            continue;
+        }
+
+        workload.ownedArrivalTime.push_back(record.arrivalTime);
+        workload.ownedNumCpuBursts.push_back(record.numCpuBursts);
+        workload.ownedTotalCpuBurstTime.push_back(record.totalCpuBurstTime);
+        workload.ownedNice.push_back(record.nice);
+        workload.ownedTickets.push_back(record.tickets);
+        workload.ownedDevice.push_back(record.device);
+        workload.ownedBurstOffset.push_back(burstStart);
+    }
+
+    workload.useOwnedStorage();
+    return errorCount == 0;
+}
+
+// Binary trace layout: a TraceFileHeader, then one 8-byte aligned section
+// per array at the offsets recorded in the header. Integers are stored in
+// host byte order; the byte-order mark rejects traces from the other
+// endianness. Version 2 added the tickets section and version 3 the device
+// section; older traces are still read, with every process holding
+// DEFAULT_TICKETS and using device 0.
+const char TRACE_MAGIC[8] = {'S', 'C', 'H', 'E', 'D', 'T', 'R', 'C'};
+const uint32_t TRACE_VERSION = 3;
+const uint32_t TRACE_BYTE_ORDER_MARK = 0x01020304;
+
+struct TraceFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrderMark;
+    uint64_t numProcesses;
+    uint64_t burstStreamSize;
+    uint64_t arrivalTimeOffset;       // int32_t[numProcesses]
+    uint64_t numCpuBurstsOffset;      // int32_t[numProcesses]
+    uint64_t totalCpuBurstTimeOffset; // int32_t[numProcesses]
+    uint64_t niceOffset;              // int8_t[numProcesses]
+    uint64_t burstOffsetOffset;       // uint64_t[numProcesses], relative to the burst stream
+    uint64_t burstStreamOffset;       // uint8_t[burstStreamSize]
+    uint64_t ticketsOffset;           // int32_t[numProcesses]; version 2 on
+    uint64_t deviceOffset;            // uint8_t[numProcesses]; version 3 on
+};
+
+// Older headers end before the offsets added since
+const size_t TRACE_V1_HEADER_SIZE = offsetof(TraceFileHeader, ticketsOffset);
+const size_t TRACE_V2_HEADER_SIZE = offsetof(TraceFileHeader, deviceOffset);
+
+static uint64_t alignUp(uint64_t offset) {
+    return (offset + 7) & ~(uint64_t)7;
+}
+
+// readVarint for untrusted input: false if the varint runs past `end` or
+// does not fit in 32 bits
+static bool readVarintWithin(const uint8_t*& p, const uint8_t* end, uint32_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (p == end) {
+            return false;
+        }
+        uint32_t byte = *p++;
+        if (shift == 28 && byte > 0x0f) {
+            return false;
+        }
+        value |= (byte & 0x7f) << shift;
+        if (byte < 0x80) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool isBinaryTrace(const MappedFile& file) {
+    return file.size() >= sizeof(TRACE_MAGIC) && memcmp(file.data(), TRACE_MAGIC, sizeof(TRACE_MAGIC)) == 0;
+}
+
+static bool mapBinaryTrace(const string& filePath, unique_ptr<MappedFile> file, Workload& workload, bool verifyBursts) {
+    auto fail = [&](const string& message) {
+        cerr << filePath << ": " << message << endl;
+        return false;
+    };
+
+    if (file->size() < TRACE_V1_HEADER_SIZE) {
+        return fail("truncated binary trace header");
+    }
+    TraceFileHeader header = {};
+    memcpy(&header, file->data(), TRACE_V1_HEADER_SIZE);
+    if (header.byteOrderMark != TRACE_BYTE_ORDER_MARK) {
+        return fail("binary trace was written on a host with different byte order");
+    }
+    if (header.version < 1 || header.version > TRACE_VERSION) {
+        return fail("unsupported binary trace version " + to_string(header.version));
+    }
+    bool hasTickets = header.version >= 2;
+    bool hasDevices = header.version >= 3;
+    size_t headerSize = hasDevices ? sizeof(TraceFileHeader) : hasTickets ? TRACE_V2_HEADER_SIZE : TRACE_V1_HEADER_SIZE;
+    if (file->size() < headerSize) {
+        return fail("truncated binary trace header");
+    }
+    memcpy(&header, file->data(), headerSize);
+
+    uint64_t n = header.numProcesses;
+    struct Section { uint64_t offset; uint64_t bytes; };
+    Section sections[] = {
+        {header.arrivalTimeOffset, n * sizeof(int32_t)},
+        {header.numCpuBurstsOffset, n * sizeof(int32_t)},
+        {header.totalCpuBurstTimeOffset, n * sizeof(int32_t)},
+        {header.niceOffset, n * sizeof(int8_t)},
+        {header.burstOffsetOffset, n * sizeof(uint64_t)},
+        {header.burstStreamOffset, header.burstStreamSize},
+        {header.ticketsOffset, hasTickets ? n * sizeof(int32_t) : 0},
+        {header.deviceOffset, hasDevices ? n * sizeof(uint8_t) : 0},
+    };
+    for (const Section& section : sections) {
+        if (n > file->size() || section.offset % 8 != 0 || section.offset > file->size() || section.bytes > file->size() - section.offset) {
+            return fail("corrupt binary trace: section outside the file");
+        }
+    }
+
+    // Hold every process to what the text parser enforces, since the
+    // schedulers index and divide by these values unchecked. Each burst
+    // takes at least a byte, so a process whose bursts cannot fit in the
+    // stream is caught without decoding them; decoding every burst costs
+    // time in the size of the stream and is left to verifyBursts.
+    const char* base = file->data();
+    const int32_t* arrivalTime = (const int32_t*)(base + header.arrivalTimeOffset);
+    const int32_t* numCpuBursts = (const int32_t*)(base + header.numCpuBurstsOffset);
+    const int32_t* totalCpuBurstTime = (const int32_t*)(base + header.totalCpuBurstTimeOffset);
+    const int8_t* nice = (const int8_t*)(base + header.niceOffset);
+    const int32_t* tickets = (const int32_t*)(base + header.ticketsOffset);
+    const uint64_t* burstOffset = (const uint64_t*)(base + header.burstOffsetOffset);
+    const uint8_t* burstStream = (const uint8_t*)(base + header.burstStreamOffset);
+    const uint8_t* burstStreamEnd = burstStream + header.burstStreamSize;
+    for (uint64_t i = 0; i < n; i++) {
+        string problem;
+        if (arrivalTime[i] < 0) {
+            problem = "a negative arrival time";
+        } else if (numCpuBursts[i] < 1) {
+            problem = "no CPU bursts";
+        } else if (nice[i] < -20 || nice[i] > 19) {
+            problem = "nice " + to_string(nice[i]) + " outside -20 to 19";
+        } else if (hasTickets && (tickets[i] < 1 || tickets[i] > MAX_TICKETS)) {
+            problem = to_string(tickets[i]) + " tickets, outside 1 to " + to_string(MAX_TICKETS);
+        } else if (burstOffset[i] >= header.burstStreamSize) {
+            problem = "no bursts in the stream";
+        } else if (2 * (uint64_t)numCpuBursts[i] - 1 > header.burstStreamSize - burstOffset[i]) {
+            problem = "bursts that run past the end of the stream";
+        } else if (verifyBursts) {
+            // CPU and I/O bursts alternate, starting and ending with CPU
+            const uint8_t* cursor = burstStream + burstOffset[i];
+            long long totalCpu = 0;
+            for (long long k = 0; k < 2LL * numCpuBursts[i] - 1 && problem.empty(); k++) {
+                uint32_t burst;
+                if (!readVarintWithin(cursor, burstStreamEnd, burst) || burst > INT_MAX) {
+                    problem = "bursts that run past the end of the stream";
+                } else if (k % 2 == 0) {
+                    totalCpu += burst;
+                }
+            }
+            if (problem.empty() && totalCpu != totalCpuBurstTime[i]) {
+                problem = "a total CPU time that does not match its bursts";
+            }
+        }
+        if (!problem.empty()) {
+            return fail("corrupt binary trace: process " + to_string(i + 1) + " has " + problem);
+        }
+    }
+
+    workload.numProcesses = n;
+    workload.arrivalTime = arrivalTime;
+    workload.numCpuBursts = numCpuBursts;
+    workload.totalCpuBurstTime = totalCpuBurstTime;
+    workload.nice = nice;
+    if (hasTickets) {
+        workload.tickets = tickets;
+    } else {
+        workload.ownedTickets.assign(n, DEFAULT_TICKETS);
+        workload.tickets = workload.ownedTickets.data();
+    }
+    if (hasDevices) {
+        workload.device = (const uint8_t*)(base + header.deviceOffset);
+    } else {
+        workload.ownedDevice.assign(n, 0);
+        workload.device = workload.ownedDevice.data();
+    }
+    workload.burstOffset = burstOffset;
+    workload.burstStream = burstStream;
+    workload.burstStreamSize = header.burstStreamSize;
+    workload.mapping = move(file);
+    return true;
+}
+
+bool readWorkloadFile(const string& filePath, Workload& workload, bool verifyBursts) {
+    unique_ptr<MappedFile> file(new MappedFile());
+    string openError;
+    if (!file->open(filePath, openError)) {
+        cerr << filePath << ": " << openError << endl;
+        return false;
+    }
+
+    workload = Workload();
+    if (isBinaryTrace(*file)) {
+        return mapBinaryTrace(filePath, move(file), workload, verifyBursts);
+    }
+    return parseTextWorkload(filePath, file->data(), file->data() + file->size(), workload);
+}
+
+bool writeBinaryTrace(const Workload& workload, const string& filePath) {
+    uint64_t n = workload.numProcesses;
+    TraceFileHeader header = {};
+    memcpy(header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    header.version = TRACE_VERSION;
+    header.byteOrderMark = TRACE_BYTE_ORDER_MARK;
+    header.numProcesses = n;
+    header.burstStreamSize = workload.burstStreamSize;
+    header.arrivalTimeOffset = alignUp(sizeof(header));
+    header.numCpuBurstsOffset = alignUp(header.arrivalTimeOffset + n * sizeof(int32_t));
+    header.totalCpuBurstTimeOffset = alignUp(header.numCpuBurstsOffset + n * sizeof(int32_t));
+    header.niceOffset = alignUp(header.totalCpuBurstTimeOffset + n * sizeof(int32_t));
+    header.burstOffsetOffset = alignUp(header.niceOffset + n * sizeof(int8_t));
+    header.burstStreamOffset = alignUp(header.burstOffsetOffset + n * sizeof(uint64_t));
+    header.ticketsOffset = alignUp(header.burstStreamOffset + workload.burstStreamSize);
+    header.deviceOffset = alignUp(header.ticketsOffset + n * sizeof(int32_t));
+
+    FILE* out = fopen(filePath.c_str(), "wb");
+    if (!out) {
+        cerr << filePath << ": " << strerror(errno) << endl;
+        return false;
+    }
+
+    uint64_t written = 0;
+    auto writeSection = [&](uint64_t offset, const void* data, uint64_t bytes) {
+        static const char padding[8] = {};
+        fwrite(padding, 1, offset - written, out);
+        fwrite(data, 1, bytes, out);
+        written = offset + bytes;
+    };
+    writeSection(0, &header, sizeof(header));
+    writeSection(header.arrivalTimeOffset, workload.arrivalTime, n * sizeof(int32_t));
+    writeSection(header.numCpuBurstsOffset, workload.numCpuBursts, n * sizeof(int32_t));
+    writeSection(header.totalCpuBurstTimeOffset, workload.totalCpuBurstTime, n * sizeof(int32_t));
+    writeSection(header.niceOffset, workload.nice, n * sizeof(int8_t));
+    writeSection(header.burstOffsetOffset, workload.burstOffset, n * sizeof(uint64_t));
+    writeSection(header.burstStreamOffset, workload.burstStream, workload.burstStreamSize);
+    writeSection(header.ticketsOffset, workload.tickets, n * sizeof(int32_t));
+    writeSection(header.deviceOffset, workload.device, n * sizeof(uint8_t));
+
+    bool ok = !ferror(out);
+    if (fclose(out) != 0 || !ok) {
+        cerr << filePath << ": write failed" << endl;
+        return false;
+    }
+    return true;
+}
+
+WorkloadStream::~WorkloadStream() {
+    if (in && in != stdin) {
+        fclose(in);
+    }
+    free(line);
+}
+
+bool WorkloadStream::open(const string& filePath) {
+    path = filePath;
+    in = filePath == "-" ? stdin : fopen(filePath.c_str(), "r");
+    if (!in) {
+        cerr << filePath << ": " << strerror(errno) << endl;
+        return false;
+    }
+    int first = getc(in);
+    if (first == TRACE_MAGIC[0]) {
+        // Binary traces start with "SCHED", which no text line does
+        cerr << filePath << ": binary traces cannot be streamed; run them without --input stream" << endl;
+        return false;
+    }
+    if (first != EOF) {
+        ungetc(first, in);
+    }
+    readAhead();
+    return !errorSeen;
+}
+
+// Read the next process line into `next`, or clear haveNext at the end of
+// the input or on the first error
+void WorkloadStream::readAhead() {
+    haveNext = false;
+    string error;
+    ssize_t length;
+    while (!errorSeen && (length = getline(&line, &lineCapacity, in)) >= 0) {
+        lineNumber++;
+        const char* lineEnd = line + length;
+        if (lineEnd > line && lineEnd[-1] == '\n') {
+            lineEnd--;
+        }
+        const char* q = skipBlanks(line, lineEnd);
+        if (q == lineEnd) {
+            continue; // Blank line
+        }
+
+        int32_t previousArrival = next.arrivalTime;
+        nextBursts.clear();
+        if (!parseProcessLine(q, lineEnd, nextBursts, next, error)) {
+            cerr << path << ":" << lineNumber << ": " << error << endl;
+            errorSeen = true;
+        } else if (next.device >= deviceLimit) {
+            cerr << path << ":" << lineNumber << ": dev=" << (int)next.device << " but only " << deviceLimit
+                 << " devices are configured" << endl;
+            errorSeen = true;
+        } else if (processesRead > 0 && next.arrivalTime < previousArrival) {
+            cerr << path << ":" << lineNumber << ": arrival time " << next.arrivalTime << " is before the previous process's "
+                 << previousArrival << "; streamed workloads must be sorted by arrival time" << endl;
+            errorSeen = true;
+        } else {
+            haveNext = true;
+            processesRead++;
+            return;
+        }
+    }
+    if (ferror(in)) {
+        cerr << path << ": " << strerror(errno) << endl;
+        errorSeen = true;
+    }
+}
+
+int WorkloadStream::admit() {
+    int slot;
+    if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        slot = (int)slots.ownedArrivalTime.size();
+        slots.ownedArrivalTime.push_back(0);
+        slots.ownedNumCpuBursts.push_back(0);
+        slots.ownedTotalCpuBurstTime.push_back(0);
+        slots.ownedNice.push_back(0);
+        slots.ownedTickets.push_back(0);
+        slots.ownedDevice.push_back(0);
+        slotBursts.emplace_back();
+        slotProcess.push_back(0);
+        slots.useOwnedStorage();
+    }
+    slots.ownedArrivalTime[slot] = next.arrivalTime;
+    slots.ownedNumCpuBursts[slot] = next.numCpuBursts;
+    slots.ownedTotalCpuBurstTime[slot] = next.totalCpuBurstTime;
+    slots.ownedNice[slot] = next.nice;
+    slots.ownedTickets[slot] = next.tickets;
+    slots.ownedDevice[slot] = next.device;
+    slotBursts[slot].swap(nextBursts);
+    slotProcess[slot] = processesRead - 1;
+    readAhead();
+    return slot;
+}
@@ -0,0 +1,183 @@
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Read-only view of a whole file, memory-mapped when possible
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    bool open(const std::string& path, std::string& error);
+    const char* data() const { return begin; }
+    size_t size() const { return length; }
+
+private:
+    const char* begin = nullptr;
+    size_t length = 0;
+    bool mapped = false;
+    std::string fallback; // Contents of files that cannot be mapped, e.g. pipes
+};
+
+// Decode one LEB128 varint and advance p past it
+inline int readVarint(const uint8_t*& p) {
+    uint32_t value = *p++;
+    if (value < 0x80) {
+        return (int)value;
+    }
+    value &= 0x7f;
+    for (int shift = 7;; shift += 7) {
+        uint32_t byte = *p++;
+        value |= (byte & 0x7f) << shift;
+        if (byte < 0x80) {
+            return (int)value;
+        }
+    }
+}
+
+inline void appendVarint(std::vector<uint8_t>& out, uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((uint8_t)value);
+}
+
+// Immutable description of a workload as parallel per-process arrays plus
+// one stream holding every process's bursts (CPU and I/O interleaved) as
+// varints. The arrays point either into the vectors below (a parsed text
+// file) or straight into a memory-mapped binary trace.
+struct Workload {
+    size_t numProcesses = 0;
+    const int32_t* arrivalTime = nullptr;
+    const int32_t* numCpuBursts = nullptr;
+    const int32_t* totalCpuBurstTime = nullptr;
+    const int8_t* nice = nullptr;
+    const int32_t* tickets = nullptr;      // Lottery and stride share
+    const uint8_t* device = nullptr;       // I/O device the process's I/O bursts go to
+    const uint64_t* burstOffset = nullptr; // Start of each process's bursts in burstStream
+    const uint8_t* burstStream = nullptr;
+    size_t burstStreamSize = 0;
+
+    Workload() = default;
+    Workload(const Workload&) = delete;
+    Workload& operator=(const Workload&) = delete;
+    Workload(Workload&&) = default;
+    Workload& operator=(Workload&&) = default;
+
+    // Backing storage for workloads built in memory (parsed text, generated)
+    std::vector<int32_t> ownedArrivalTime;
+    std::vector<int32_t> ownedNumCpuBursts;
+    std::vector<int32_t> ownedTotalCpuBurstTime;
+    std::vector<int8_t> ownedNice;
+    std::vector<int32_t> ownedTickets;
+    std::vector<uint8_t> ownedDevice;
+    std::vector<uint64_t> ownedBurstOffset;
+    std::vector<uint8_t> ownedBurstStream;
+
+    // Backing storage for binary traces
+    std::unique_ptr<MappedFile> mapping;
+
+    // Point the arrays above at the owned vectors once they are filled
+    void useOwnedStorage();
+};
+
+// Tickets of a process that declares none, and the most one may hold
+const int32_t DEFAULT_TICKETS = 100;
+const int32_t MAX_TICKETS = 1000000;
+
+// I/O devices a process may name; a process that names none uses device 0
+const int MAX_DEVICES = 256;
+
+// One process line of a text workload
+struct ProcessRecord {
+    int32_t arrivalTime = 0;
+    int32_t numCpuBursts = 0;
+    int32_t totalCpuBurstTime = 0;
+    int8_t nice = 0;
+    int32_t tickets = DEFAULT_TICKETS;
+    uint8_t device = 0;
+};
+
+// Parse the process described by [begin, end), a non-blank line without its
+// newline, appending its bursts to `bursts` as varints. On failure `bursts`
+// is left as it was and `error` describes the problem.
+bool parseProcessLine(const char* begin, const char* end, std::vector<uint8_t>& bursts, ProcessRecord& record, std::string& error);
+
+// Text workload read lazily, one process at a time, for streaming runs. A
+// process is admitted into a slot when the run reaches its arrival time and
+// its slot is reused once the run retires it, so memory tracks the number
+// of processes alive at once rather than the length of the input. The
+// slots are exposed as a Workload whose arrays are indexed by slot (the
+// burst stream is per slot, see burstsOf). Arrival times must not
+// decrease; a malformed or out-of-order line ends the stream with an error.
+class WorkloadStream {
+public:
+    WorkloadStream() = default;
+    WorkloadStream(const WorkloadStream&) = delete;
+    WorkloadStream& operator=(const WorkloadStream&) = delete;
+    ~WorkloadStream();
+
+    // Start reading filePath, or stdin for "-"; problems go to stderr
+    bool open(const std::string& filePath);
+    // Before open: treat a process naming device `count` or above as an
+    // error, for runs that simulate only that many devices
+    void limitDevices(int count) { deviceLimit = count; }
+
+    const Workload& workload() const { return slots; }
+    bool hasNext() const { return haveNext; }
+    int32_t nextArrival() const { return next.arrivalTime; }
+
+    // Move the next process into a free slot and return the slot
+    int admit();
+    // The process in `slot` is done with; the slot may be reused
+    void retire(int slot) { freeSlots.push_back(slot); }
+
+    const uint8_t* burstsOf(int slot) const { return slotBursts[slot].data(); }
+    // Input-order index of the process in each slot
+    const std::vector<int>& processNumbers() const { return slotProcess; }
+
+    bool failed() const { return errorSeen; }
+
+private:
+    std::string path;
+    FILE* in = nullptr;
+    char* line = nullptr;
+    size_t lineCapacity = 0;
+    int lineNumber = 0;
+    bool errorSeen = false;
+    int deviceLimit = MAX_DEVICES;
+
+    bool haveNext = false;
+    ProcessRecord next;
+    std::vector<uint8_t> nextBursts;
+    int processesRead = 0;
+
+    Workload slots;
+    std::vector<std::vector<uint8_t>> slotBursts;
+    std::vector<int> slotProcess;
+    std::vector<int> freeSlots;
+
+    void readAhead();
+};
+
+// Load a workload, detecting whether the file is a text workload
+// description or a binary trace written by writeBinaryTrace. Problems,
+// including malformed text lines with their line number, are reported on
+// stderr and make the load fail. A binary trace is mapped after checks
+// that take time in its process count; verifyBursts also decodes its whole
+// burst stream, for traces that did not come from writeBinaryTrace.
+bool readWorkloadFile(const std::string& filePath, Workload& workload, bool verifyBursts = false);
+
+// Write a workload in the versioned binary trace format
+bool writeBinaryTrace(const Workload& workload, const std::string& filePath);
+
+#endif
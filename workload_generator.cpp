@@ -0,0 +1,82 @@
+#include "workload_generator.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <random>
+using namespace std;
+
+bool parseBurstDistribution(const string& name, BurstDistribution& distribution) {
+    if (name == "exponential") {
+        distribution = EXPONENTIAL_BURSTS;
+    } else if (name == "bimodal") {
+        distribution = BIMODAL_BURSTS;
+    } else if (name == "heavy-tailed") {
+        distribution = HEAVY_TAILED_BURSTS;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Draw a burst length with the given mean, rounded to at least one time unit
+static int drawBurst(mt19937_64& rng, BurstDistribution distribution, double mean) {
+    uniform_real_distribution<double> uniform(0.0, 1.0);
+    double value;
+    switch (distribution) {
+    case BIMODAL_BURSTS:
+        // 80% at a quarter of the mean, 20% at four times the mean
+        value = exponential_distribution<double>(1.0)(rng) * (uniform(rng) < 0.8 ? mean / 4 : mean * 4);
+        break;
+    case HEAVY_TAILED_BURSTS: {
+        const double alpha = 1.5;
+        double scale = mean * (alpha - 1) / alpha;
+        value = scale / pow(1.0 - uniform(rng), 1.0 / alpha);
+        break;
+    }
+    default:
+        value = exponential_distribution<double>(1.0 / mean)(rng);
+        break;
+    }
+    return (int)min<double>(max(1.0, round(value)), INT_MAX / 64);
+}
+
+Workload generateWorkload(const GeneratorConfig& config) {
+    mt19937_64 rng(config.seed);
+    geometric_distribution<int> extraBursts(1.0 / config.meanCpuBursts);
+    double meanInterarrival = config.meanCpuBursts * config.meanCpuBurst / (config.load * config.cpus);
+    exponential_distribution<double> interarrival(1.0 / meanInterarrival);
+
+    Workload workload;
+    size_t n = config.numProcesses;
+    workload.ownedArrivalTime.reserve(n);
+    workload.ownedNumCpuBursts.reserve(n);
+    workload.ownedTotalCpuBurstTime.reserve(n);
+    workload.ownedNice.assign(n, 0);
+    workload.ownedTickets.assign(n, DEFAULT_TICKETS);
+    workload.ownedDevice.resize(n);
+    workload.ownedBurstOffset.reserve(n);
+
+    double arrival = 0;
+    for (size_t i = 0; i < n; i++) {
+        int cpuBursts = 1 + extraBursts(rng);
+        long long totalCpu = 0;
+        workload.ownedArrivalTime.push_back((int32_t)min<double>(arrival, INT_MAX));
+        workload.ownedBurstOffset.push_back(workload.ownedBurstStream.size());
+        for (int k = 0; k < cpuBursts; k++) {
+            if (k > 0) {
+                appendVarint(workload.ownedBurstStream, drawBurst(rng, config.distribution, config.meanCpuBurst * config.ioRatio));
+            }
+            int burst = drawBurst(rng, config.distribution, config.meanCpuBurst);
+            totalCpu += burst;
+            appendVarint(workload.ownedBurstStream, burst);
+        }
+        workload.ownedNumCpuBursts.push_back(cpuBursts);
+        workload.ownedDevice[i] = (uint8_t)(i % config.devices);
+        workload.ownedTotalCpuBurstTime.push_back((int32_t)min<long long>(totalCpu, INT_MAX));
+        arrival += interarrival(rng);
+    }
+
+    workload.useOwnedStorage();
+    return workload;
+}
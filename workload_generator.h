@@ -0,0 +1,31 @@
+#ifndef WORKLOAD_GENERATOR_H
+#define WORKLOAD_GENERATOR_H
+
+#include <cstdint>
+#include <string>
+#include "workload.h"
+
+enum BurstDistribution {
+    EXPONENTIAL_BURSTS,
+    BIMODAL_BURSTS,     // Mostly short bursts with a few long ones, same mean
+    HEAVY_TAILED_BURSTS // Pareto with alpha 1.5, same mean
+};
+
+bool parseBurstDistribution(const std::string& name, BurstDistribution& distribution);
+
+struct GeneratorConfig {
+    int numProcesses = 100000;
+    uint64_t seed = 1;
+    BurstDistribution distribution = EXPONENTIAL_BURSTS;
+    double meanCpuBurst = 20;
+    double ioRatio = 1.0;            // Mean I/O burst relative to the mean CPU burst
+    double meanCpuBursts = 4;        // CPU bursts per process (geometric, at least 1)
+    double load = 0.9;               // Offered load per CPU, which sets the arrival rate
+    int cpus = 1;                    // CPUs the load is spread over
+    int devices = 1;                 // I/O devices the processes are dealt over in turn
+};
+
+// Build a synthetic workload. The same config always yields the same workload.
+Workload generateWorkload(const GeneratorConfig& config);
+
+#endif